@@ -0,0 +1,279 @@
+/*
+	Module Name: batch.cpp
+	Description: Runs a batch, i.e. the simulations listed in a manifest, in one process. Jobs 		are run by a pool of worker threads that steal jobs from each other once they run out. 		Every rfile is loaded once and its random numbers are shared read-only by all jobs 		using it. Each job writes its output to its own file and a summary CSV lists the 		TOTALCOST of every job.
+
+	Manifest format, one job per line, empty lines and lines starting with # are skipped:
+		<inputfile> <rfile> <algo> <frames> [options]
+	options are the letters of -o, e.g. OPFS, and may be left out.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include "simulator.h"
+
+#define BATCH_ALGOS "fsrncaluAqpo" //algorithms a job may ask for
+
+
+/*************************** imported from random.cpp ***************************/
+extern RandomTable* load_random_numbers(char *filename);
+
+
+struct BatchJob {
+	/*
+		Struct Name: BatchJob
+		Description: defines one simulation of a batch and its results
+	*/
+	std::string input; //path to input file
+	std::string rfile; //path to rfile
+	std::string options; //letters of -o
+	SimulatorConfig config; //options of simulation, output_fd is set when the job runs
+
+	//results, valid once the job ran
+	unsigned long int instructions, ctx_switches;
+	unsigned long long int total_cost;
+};
+
+
+class JobQueues {
+	/*
+		Class Name: JobQueues
+		Description: one double ended queue of job indexes per worker. A worker takes jobs 		from the back of its own queue and, once that is empty, steals from the front of the 		others. Jobs are dealt in contiguous blocks, so a worker runs jobs in manifest order 		until it has to steal.
+	*/
+private:
+	std::vector<std::deque<int> > queues;
+	std::vector<std::mutex*> locks;
+
+public:
+	JobQueues(int num_jobs, int num_workers) : queues(num_workers) {
+		for(int w = 0; w < num_workers; w++) {
+			locks.push_back(new std::mutex());
+			for(int j = (long long int)num_jobs*w/num_workers; j < (long long int)num_jobs*(w + 1)/num_workers; j++) {
+				queues[w].push_front(j);
+			}
+		}
+	}
+
+	~JobQueues() {
+		for(int w = 0; w < (int)locks.size(); w++) {
+			delete locks[w];
+		}
+	}
+
+	int next(int worker) {
+		/*
+			Function Name: next
+			Arguments:
+				int worker: index of worker asking for a job
+			Returns: int - index of next job to be run by worker, -1 if no job is left
+			Description: takes a job of the own queue or steals one from another worker. Jobs 			are never added, so once all queues are empty the worker is done.
+		*/
+		int num_workers = queues.size();
+		for(int i = 0; i < num_workers; i++) {
+			int victim = (worker + i) % num_workers;
+			std::lock_guard<std::mutex> guard(*locks[victim]);
+			if(queues[victim].empty()) continue;
+			int job;
+			if(victim == worker) {
+				job = queues[victim].back();
+				queues[victim].pop_back();
+			} else {
+				job = queues[victim].front();
+				queues[victim].pop_front();
+			}
+			return job;
+		}
+		return -1;
+	}
+};
+
+
+bool parse_manifest(char *filename, int vpage_bits, std::vector<BatchJob> &jobs) {
+	/*
+		Function Name: parse_manifest
+		Arguments:
+			char *filename: path to manifest
+			int vpage_bits: width of virtual address space in pages, same for all jobs
+			std::vector<BatchJob> &jobs: filled with the jobs of manifest
+		Returns: bool - false if manifest can not be read or has an invalid job
+		Description: reads and checks all jobs up front, so a bad job does not stop the 		batch half way
+	*/
+	FILE *manifest = fopen(filename, "r");
+	if(manifest == NULL) {
+		perror(filename);
+		return false;
+	}
+
+	char line[4096];
+	int line_num = 0;
+	bool ok = true;
+	while(fgets(line, sizeof(line), manifest) != NULL) {
+		line_num++;
+		char input[1024], rfile[1024], algo[16], options[64] = "";
+		int frames;
+		if(line[0] == '#') continue;
+		int fields = sscanf(line, "%1023s %1023s %15s %d %63s", input, rfile, algo, &frames, options);
+		if(fields <= 0) continue;
+
+		if(fields < 4 || strlen(algo) != 1 || strchr(BATCH_ALGOS, algo[0]) == NULL) {
+			fprintf(stderr, "%s:%d: expected <inputfile> <rfile> <algo> <frames> [options]\n", filename, line_num);
+			ok = false;
+			continue;
+		}
+		if(frames < 1 || frames > MAX_FRAMES) {
+			fprintf(stderr, "%s:%d: number of frames must be between 1 and %d\n", filename, line_num, MAX_FRAMES);
+			ok = false;
+			continue;
+		}
+		if(access(input, R_OK) != 0 || access(rfile, R_OK) != 0) {
+			fprintf(stderr, "%s:%d: can not read %s\n", filename, line_num, access(input, R_OK) != 0 ? input : rfile);
+			ok = false;
+			continue;
+		}
+
+		BatchJob job;
+		job.input = input;
+		job.rfile = rfile;
+		job.options = options;
+		job.config.algo = algo[0];
+		job.config.frame_limit = frames;
+		job.config.vpage_bits = vpage_bits;
+		job.config.O_flag = (strchr(options, 'O') != NULL);
+		job.config.P_flag = (strchr(options, 'P') != NULL);
+		job.config.F_flag = (strchr(options, 'F') != NULL);
+		job.config.S_flag = (strchr(options, 'S') != NULL);
+		job.config.x_flag = (strchr(options, 'x') != NULL);
+		job.config.f_flag = (strchr(options, 'f') != NULL);
+		job.config.output_fd = -1;
+		job.config.random_table = NULL;
+		job.config.partition = -1;
+		memset(&job.config.tlb, 0, sizeof(job.config.tlb));
+		job.config.huge_pages = 0;
+		memset(&job.config.kswapd, 0, sizeof(job.config.kswapd));
+		job.instructions = job.ctx_switches = 0;
+		job.total_cost = 0;
+		jobs.push_back(job);
+	}
+	fclose(manifest);
+	return ok;
+}
+
+
+void run_job(BatchJob *job, int index, const char *output_dir) {
+	/*
+		Function Name: run_job
+		Arguments:
+			BatchJob *job: job to be run, its results are filled in
+			int index: index of job in manifest, names its output file
+			const char *output_dir: directory output files are written to
+		Returns: void
+		Description: simulates the input file of job and writes the output to job<index>.out
+	*/
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/job%d.out", output_dir, index);
+	job->config.output_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(job->config.output_fd < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	InputFile input(job->config.vpage_bits);
+	input.openInputFile((char*)job->input.c_str());
+	input.initProcess();
+
+	//output is flushed and the writer joined once the simulator is gone
+	{
+		Simulator simulator(job->config, &input);
+		simulator.simulate(&input);
+		job->instructions = simulator.instr_num + 1;
+		job->ctx_switches = simulator.ctx_switches;
+		job->total_cost = simulator.get_total_cost();
+	}
+	close(job->config.output_fd);
+}
+
+
+void batch_worker(JobQueues *queues, int worker, std::vector<BatchJob> *jobs, const char *output_dir) {
+	/*
+		Function Name: batch_worker
+		Arguments:
+			JobQueues *queues: source of jobs
+			int worker: index of this worker
+			std::vector<BatchJob> *jobs: all jobs of batch
+			const char *output_dir: directory output files are written to
+		Returns: void
+		Description: runs jobs until none is left
+	*/
+	int job;
+	while((job = queues->next(worker)) >= 0) {
+		run_job(&(*jobs)[job], job, output_dir);
+	}
+}
+
+
+int run_batch(char *manifest, int vpage_bits, const char *output_dir, int num_threads) {
+	/*
+		Function Name: run_batch
+		Arguments:
+			char *manifest: path to manifest
+			int vpage_bits: width of virtual address space in pages
+			const char *output_dir: directory output files and summary.csv are written to
+			int num_threads: number of worker threads, 0 for one per hardware thread
+		Returns: int - program exit status
+		Description: runs all jobs of manifest and writes summary.csv
+	*/
+	std::vector<BatchJob> jobs;
+	if(!parse_manifest(manifest, vpage_bits, jobs)) return 1;
+
+	//every rfile is loaded once and shared read-only by its jobs
+	std::map<std::string, RandomTable*> tables;
+	for(int j = 0; j < (int)jobs.size(); j++) {
+		RandomTable *&table = tables[jobs[j].rfile];
+		if(table == NULL) table = load_random_numbers((char*)jobs[j].rfile.c_str());
+		if(table->size <= 0) {
+			fprintf(stderr, "%s: no random numbers\n", jobs[j].rfile.c_str());
+			return 1;
+		}
+		jobs[j].config.random_table = table;
+	}
+
+	if(num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+	if(num_threads <= 0) num_threads = 1;
+	if(num_threads > (int)jobs.size()) num_threads = jobs.size();
+
+	JobQueues queues(jobs.size(), num_threads);
+	std::vector<std::thread> workers;
+	for(int t = 0; t < num_threads; t++) {
+		workers.push_back(std::thread(batch_worker, &queues, t, &jobs, output_dir));
+	}
+	for(int t = 0; t < num_threads; t++) {
+		workers[t].join();
+	}
+
+	//summary of every job in manifest order
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/summary.csv", output_dir);
+	FILE *summary = fopen(path, "w");
+	if(summary == NULL) {
+		perror(path);
+		return 1;
+	}
+	fprintf(summary, "job,input,rfile,algo,frames,options,ctx_switches,instructions,total_cost\n");
+	for(int j = 0; j < (int)jobs.size(); j++) {
+		BatchJob &job = jobs[j];
+		fprintf(summary, "%d,%s,%s,%c,%d,%s,%lu,%lu,%llu\n", j, job.input.c_str(), job.rfile.c_str(), job.config.algo, job.config.frame_limit, job.options.c_str(), job.ctx_switches, job.instructions, job.total_cost);
+	}
+	fclose(summary);
+
+	for(std::map<std::string, RandomTable*>::iterator it = tables.begin(); it != tables.end(); it++) {
+		delete[] it->second->numbers;
+		delete it->second;
+	}
+	return 0;
+}
@@ -0,0 +1,518 @@
+/*
+	Module Name: microbench.cpp
+	Description: Microbenchmarks of every pager and of whole simulations, results are written as 		JSON in the format of Google Benchmark so existing tools can compare two runs.
+	BM_Fault/<pager>/<frames> handles faults on a full frame table: the pager picks a victim, 		the victim is unmapped and a page of a pool twice the size of memory is mapped in its 		place, then a few random frames are referenced. One iteration is one fault.
+	BM_Simulate/<pager>/<frames> simulates a whole input file, usually written by tracegen, 		without any output flags. One iteration is one simulation, items are commands.
+	With -p BM_Pipeline/<pager>/<frames>/j<stages> is run instead, the same simulation with O 		and S output written to /dev/null, sequentially as mmu -j1 does and as the three stage 		pipeline of mmu -j3. Wall clock time is what the pipeline saves, CPU time is what it 		costs.
+	Every benchmark runs batches of growing size until it has run for the minimum time.
+	Usage: ./microbench [-t inputfile] [-o results.json] [-m max_frames] [-s max_sim_frames] 		[-T min_time] [-a algos] [-p]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "../pager.h"
+#include "../simulator.h"
+
+#define BENCH_ALGOS "fsrncaluAqpo" //all pagers, in order of -a of mmu
+#define BENCH_PAGE_BITS 16 //width of address space of every process of page pool
+#define BENCH_TOUCHES 4 //frames referenced between two faults
+#define BENCH_MAX_OPT_FAULTS (1 << 20) //faults of OPT benchmark, bounded by its next uses
+
+
+/**************************** Global Variables ****************************/
+RandomTable random_table; //random numbers, generated instead of loaded from an rfile
+
+
+struct BenchResult {
+	/*
+		Struct Name: BenchResult
+		Description: defines the measurement of one benchmark
+	*/
+	std::string name; //BM_<benchmark>/<pager>/<frames>
+	unsigned long long int iterations; //iterations run in total
+	double real_time; //wall clock time per iteration in ns
+	double cpu_time; //CPU time of process per iteration in ns
+	double items_per_second; //items handled per wall clock second
+};
+
+
+//runs a number of iterations of a benchmark, returns the number of items handled
+typedef unsigned long long int (*BenchBody)(void *context, unsigned long long int iterations);
+
+
+struct FaultBench {
+	/*
+		Struct Name: FaultBench
+		Description: defines the state of a fault benchmark, a full frame table and a pool 		of pages twice its size spread over processes
+	*/
+	Process **processes; //owners of page pool
+	int num_processes; //number of processes
+	Frame *frame_table; //all frames, every one holds a page
+	int frame_limit; //memory size
+	std::vector<int> nonresident; //pages of pool not in memory, as process << BENCH_PAGE_BITS | page
+	std::vector<uint64_t> next_use; //synthetic next uses for OPT
+	RandomGenerator random; //random numbers of pager
+	Pager *pager; //pager being measured
+	unsigned int seed; //state of random choices of benchmark
+};
+
+
+double now(clockid_t clock) {
+	/*
+		Function Name: now
+		Arguments:
+			clockid_t clock: CLOCK_MONOTONIC for wall clock time, CLOCK_PROCESS_CPUTIME_ID for 			CPU time
+		Returns: double - time in seconds
+	*/
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+
+void generate_random_numbers(int size) {
+	/*
+		Function Name: generate_random_numbers
+		Arguments:
+			int size: number of random numbers
+		Returns: void
+		Description: fills the random numbers with a linear congruential generator so the 		benchmark does not need an rfile
+	*/
+	unsigned int seed = 12345;
+	random_table.size = size;
+	random_table.numbers = new int[size];
+	for(int i = 0; i < size; i++) {
+		seed = seed*1103515245 + 12345;
+		random_table.numbers[i] = seed >> 1;
+	}
+}
+
+
+unsigned int next_random(unsigned int *seed) {
+	/*
+		Function Name: next_random
+		Arguments:
+			unsigned int *seed: state of generator, advanced
+		Returns: unsigned int - 31 bit random number
+		Description: xorshift generator for choices of the benchmark itself, so the random 		numbers of pager are not used up by them
+	*/
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed >> 1;
+}
+
+
+Pager* make_pager(char algo, FaultBench *bench) {
+	/*
+		Function Name: make_pager
+		Arguments:
+			char algo: algorithm letter as given to -a of mmu
+			FaultBench *bench: benchmark owning frame table and random numbers
+		Returns: Pager* - new pager of algorithm
+	*/
+	Frame *frame_table = bench->frame_table;
+	int frame_limit = bench->frame_limit;
+	RandomGenerator *random = &bench->random;
+	switch(algo) {
+	case 'f': return new FIFOPager(frame_table, frame_limit, random);
+	case 's': return new SecondChancePager(frame_table, frame_limit, random);
+	case 'r': return new RandomPager(frame_table, frame_limit, random);
+	case 'n': return new NRUPager(frame_table, frame_limit, random);
+	case 'c': return new ClockPager(frame_table, frame_limit, random);
+	case 'a': return new AgingPager(frame_table, frame_limit, random);
+	case 'l': return new LRUPager(frame_table, frame_limit, random);
+	case 'u': return new LFUPager(frame_table, frame_limit, random);
+	case 'A': return new ARCPager(frame_table, frame_limit, random);
+	case 'q': return new TwoQPager(frame_table, frame_limit, random);
+	case 'p': return new ClockProPager(frame_table, frame_limit, random);
+	default: return new OPTPager(frame_table, frame_limit, random, &bench->next_use);
+	}
+}
+
+
+const char* pager_name(char algo) {
+	/*
+		Function Name: pager_name
+		Arguments:
+			char algo: algorithm letter as given to -a of mmu
+		Returns: const char* - name of pager used in benchmark names
+	*/
+	switch(algo) {
+	case 'f': return "FIFO";
+	case 's': return "SecondChance";
+	case 'r': return "Random";
+	case 'n': return "NRU";
+	case 'c': return "Clock";
+	case 'a': return "Aging";
+	case 'l': return "LRU";
+	case 'u': return "LFU";
+	case 'A': return "ARC";
+	case 'q': return "2Q";
+	case 'p': return "ClockPro";
+	default: return "OPT";
+	}
+}
+
+
+void map_page(FaultBench *bench, Frame *frame, int page) {
+	/*
+		Function Name: map_page
+		Arguments:
+			FaultBench *bench: benchmark the frame belongs to
+			Frame *frame: free or just unmapped frame
+			int page: page of pool to be mapped, as process << BENCH_PAGE_BITS | page
+		Returns: void
+		Description: maps page to frame and references it, as simulate_command() does for a 		page that was not in memory
+	*/
+	int pid = page >> BENCH_PAGE_BITS;
+	int page_number = page & ((1 << BENCH_PAGE_BITS) - 1);
+	PTE *pte = bench->processes[pid]->page_table.lookup(page_number);
+	pte->referenced = 0;
+	pte->modified = 0;
+	pte->frame_assigned = 1;
+	pte->frame_index = frame->frame_number;
+	frame->process_id = pid;
+	frame->page_number = page_number;
+	frame->pte = pte;
+	pte->referenced = 1;
+	bench->pager->reference_frame(frame);
+}
+
+
+FaultBench* setup_faults(char algo, int frames) {
+	/*
+		Function Name: setup_faults
+		Arguments:
+			char algo: pager to be benchmarked
+			int frames: number of frames
+		Returns: FaultBench* - benchmark with every frame holding a page of pool
+		Description: creates the page pool and fills memory with its first half
+	*/
+	FaultBench *bench = new FaultBench();
+	int pool = 2*frames;
+	bench->frame_limit = frames;
+	bench->num_processes = ((pool - 1) >> BENCH_PAGE_BITS) + 1;
+	bench->processes = new Process*[bench->num_processes];
+	for(int i = 0; i < bench->num_processes; i++) {
+		bench->processes[i] = new Process(i, BENCH_PAGE_BITS);
+	}
+	for(int page = 0; page < pool; page++) {
+		PTE *pte = bench->processes[page >> BENCH_PAGE_BITS]->page_table.populate(page & ((1 << BENCH_PAGE_BITS) - 1));
+		pte->valid = 1;
+	}
+
+	//next uses of OPT lie up to two pool sizes of references ahead
+	bench->seed = 2463534242u;
+	if(algo == 'o') {
+		uint64_t refs = frames + (uint64_t)BENCH_MAX_OPT_FAULTS*(1 + BENCH_TOUCHES);
+		bench->next_use.resize(refs);
+		for(uint64_t i = 0; i < refs; i++) {
+			bench->next_use[i] = i + 1 + next_random(&bench->seed) % (2*pool);
+		}
+	}
+
+	bench->frame_table = new Frame[frames];
+	for(int i = 0; i < frames; i++) {
+		bench->frame_table[i].frame_number = i;
+		bench->frame_table[i].process_id = -1;
+		bench->frame_table[i].pte = NULL;
+	}
+	bench->random = RandomGenerator(&random_table);
+	bench->pager = make_pager(algo, bench);
+	for(int i = 0; i < frames; i++) {
+		bench->pager->page_fault(i >> BENCH_PAGE_BITS, i & ((1 << BENCH_PAGE_BITS) - 1));
+		map_page(bench, &bench->frame_table[i], i);
+	}
+	for(int page = frames; page < pool; page++) {
+		bench->nonresident.push_back(page);
+	}
+	return bench;
+}
+
+
+void teardown_faults(FaultBench *bench) {
+	/*
+		Function Name: teardown_faults
+		Arguments:
+			FaultBench *bench: benchmark to be released
+		Returns: void
+	*/
+	delete bench->pager;
+	for(int i = 0; i < bench->num_processes; i++) {
+		delete bench->processes[i];
+	}
+	delete[] bench->processes;
+	delete[] bench->frame_table;
+	delete bench;
+}
+
+
+unsigned long long int run_faults(void *context, unsigned long long int iterations) {
+	/*
+		Function Name: run_faults
+		Arguments:
+			void *context: FaultBench being run
+			unsigned long long int iterations: number of faults
+		Returns: unsigned long long int - number of faults handled
+		Description: faults on random pages that are not in memory, the victim goes back 		to the pool
+	*/
+	FaultBench *bench = (FaultBench*)context;
+	for(unsigned long long int n = 0; n < iterations; n++) {
+		int slot = next_random(&bench->seed) % bench->nonresident.size();
+		int page = bench->nonresident[slot];
+		bench->pager->page_fault(page >> BENCH_PAGE_BITS, page & ((1 << BENCH_PAGE_BITS) - 1));
+		Frame *frame = bench->pager->determine_victim_frame();
+		frame->pte->frame_assigned = 0;
+		bench->nonresident[slot] = (frame->process_id << BENCH_PAGE_BITS) | frame->page_number;
+		map_page(bench, frame, page);
+
+		for(int k = 0; k < BENCH_TOUCHES; k++) {
+			Frame *touched = &bench->frame_table[next_random(&bench->seed) % bench->frame_limit];
+			touched->pte->referenced = 1;
+			if(k & 1) touched->pte->modified = 1;
+			bench->pager->reference_frame(touched);
+		}
+	}
+	return iterations;
+}
+
+
+struct SimulateBench {
+	/*
+		Struct Name: SimulateBench
+		Description: defines the state of a simulation benchmark
+	*/
+	InputFile *input; //input file, rewound after every simulation
+	SimulatorConfig config; //options of every simulation
+	unsigned long long int commands; //commands of input file, known after first simulation
+	int num_stages; //1 for the sequential loop, 2 or 3 for the pipeline
+};
+
+
+unsigned long long int run_simulations(void *context, unsigned long long int iterations) {
+	/*
+		Function Name: run_simulations
+		Arguments:
+			void *context: SimulateBench being run
+			unsigned long long int iterations: number of simulations
+		Returns: unsigned long long int - number of commands simulated
+	*/
+	SimulateBench *bench = (SimulateBench*)context;
+	for(unsigned long long int n = 0; n < iterations; n++) {
+		Simulator simulator(bench->config, bench->input);
+		if(bench->num_stages > 1) simulator.simulate_pipelined(bench->input, bench->num_stages);
+		else simulator.simulate(bench->input);
+		bench->commands = simulator.instr_num + 1;
+		bench->input->rewindInput();
+	}
+	return iterations*bench->commands;
+}
+
+
+BenchResult measure(std::string name, BenchBody body, void *context, double min_time, unsigned long long int max_iterations) {
+	/*
+		Function Name: measure
+		Arguments:
+			std::string name: name of benchmark
+			BenchBody body: runs iterations of benchmark
+			void *context: state passed to body
+			double min_time: seconds the benchmark runs for at least
+			unsigned long long int max_iterations: iterations the benchmark runs for at most
+		Returns: BenchResult - time per iteration over all batches
+		Description: starts with one iteration and grows the batch towards what is 		predicted to fill the minimum time, at most tenfold per batch
+	*/
+	unsigned long long int iterations = 0, items = 0, batch = 1;
+	double real_time = 0, cpu_time = 0;
+	while(real_time < min_time && iterations < max_iterations) {
+		if(batch > max_iterations - iterations) batch = max_iterations - iterations;
+		double real_start = now(CLOCK_MONOTONIC);
+		double cpu_start = now(CLOCK_PROCESS_CPUTIME_ID);
+		items += body(context, batch);
+		cpu_time += now(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+		real_time += now(CLOCK_MONOTONIC) - real_start;
+		iterations += batch;
+
+		double predicted = (real_time > 0) ? 1.4*min_time*iterations/real_time : 10.0*iterations;
+		unsigned long long int next = (predicted > 10.0*iterations) ? 10*iterations : (unsigned long long int)predicted;
+		batch = (next > iterations) ? next - iterations : 1;
+	}
+
+	BenchResult result;
+	result.name = name;
+	result.iterations = iterations;
+	result.real_time = real_time*1e9/iterations;
+	result.cpu_time = cpu_time*1e9/iterations;
+	result.items_per_second = items/real_time;
+	printf("%-32s %12.0f ns %12.0f ns %12llu %14.0f items/s\n", name.c_str(), result.real_time, result.cpu_time, result.iterations, result.items_per_second);
+	fflush(stdout);
+	return result;
+}
+
+
+bool write_json(const char *path, const char *executable, double min_time, std::vector<BenchResult> &results) {
+	/*
+		Function Name: write_json
+		Arguments:
+			const char *path: file the results are written to
+			const char *executable: path of this program, recorded in context
+			double min_time: minimum time of every benchmark, recorded in context
+			std::vector<BenchResult> &results: results of all benchmarks
+		Returns: bool - false if file could not be written
+		Description: writes results as Google Benchmark does with --benchmark_out, so 		compare.py of Google Benchmark can diff two of them
+	*/
+	FILE *file = fopen(path, "w");
+	if(file == NULL) {
+		perror(path);
+		return false;
+	}
+
+	char date[64], host[256];
+	time_t t = time(NULL);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&t));
+	if(gethostname(host, sizeof(host)) != 0) strcpy(host, "unknown");
+	host[sizeof(host) - 1] = '\0';
+
+	fprintf(file, "{\n  \"context\": {\n");
+	fprintf(file, "    \"date\": \"%s\",\n", date);
+	fprintf(file, "    \"host_name\": \"%s\",\n", host);
+	fprintf(file, "    \"executable\": \"%s\",\n", executable);
+	fprintf(file, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+	fprintf(file, "    \"min_time\": %g,\n", min_time);
+	fprintf(file, "    \"library_build_type\": \"release\"\n  },\n");
+	fprintf(file, "  \"benchmarks\": [\n");
+	for(int i = 0; i < (int)results.size(); i++) {
+		BenchResult &r = results[i];
+		fprintf(file, "    {\n");
+		fprintf(file, "      \"name\": \"%s\",\n", r.name.c_str());
+		fprintf(file, "      \"run_name\": \"%s\",\n", r.name.c_str());
+		fprintf(file, "      \"run_type\": \"iteration\",\n");
+		fprintf(file, "      \"repetitions\": 1,\n");
+		fprintf(file, "      \"repetition_index\": 0,\n");
+		fprintf(file, "      \"threads\": 1,\n");
+		fprintf(file, "      \"iterations\": %llu,\n", r.iterations);
+		fprintf(file, "      \"real_time\": %.4f,\n", r.real_time);
+		fprintf(file, "      \"cpu_time\": %.4f,\n", r.cpu_time);
+		fprintf(file, "      \"time_unit\": \"ns\",\n");
+		fprintf(file, "      \"items_per_second\": %.4f\n", r.items_per_second);
+		fprintf(file, "    }%s\n", (i + 1 < (int)results.size()) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	return fclose(file) == 0;
+}
+
+
+int main(int argc, char *argv[]) {
+	/*
+		Function Name: main
+		Arguments:
+			int argc: number of command line arguments
+			char *argv[]: string array containing all the command line arguments
+		Returns: int: program exit status
+		Description: runs the fault benchmarks from 16 frames up by factors of 4, then the 		simulation or pipeline benchmarks if an input file is given, and writes the JSON
+	*/
+	const char *trace = NULL;
+	const char *json = NULL;
+	int max_frames = 1 << 20;
+	int max_sim_frames = 4096;
+	double min_time = 0.2;
+	const char *algos = BENCH_ALGOS;
+	bool pipeline = false;
+
+	int opt;
+	while((opt = getopt(argc, argv, "t:o:m:s:T:a:p")) != -1) {
+		switch(opt) {
+		case 't':
+			trace = optarg;
+			break;
+		case 'o':
+			json = optarg;
+			break;
+		case 'm':
+			max_frames = atoi(optarg);
+			break;
+		case 's':
+			max_sim_frames = atoi(optarg);
+			break;
+		case 'T':
+			min_time = atof(optarg);
+			break;
+		case 'a':
+			algos = optarg;
+			break;
+		case 'p':
+			pipeline = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t inputfile] [-o results.json] [-m max_frames] [-s max_sim_frames] [-T min_time] [-a algos] [-p]\n", argv[0]);
+			return 1;
+		}
+	}
+	for(const char *a = algos; *a != '\0'; a++) {
+		if(strchr(BENCH_ALGOS, *a) == NULL) {
+			fprintf(stderr, "unknown algorithm %c\n", *a);
+			return 1;
+		}
+	}
+	if(max_frames > MAX_FRAMES) max_frames = MAX_FRAMES;
+	generate_random_numbers(40000);
+
+	std::vector<BenchResult> results;
+	printf("%-32s %15s %15s %12s\n", "benchmark", "time", "cpu", "iterations");
+	for(const char *a = algos; *a != '\0'; a++) {
+		for(int frames = 16; frames <= max_frames; frames *= 4) {
+			char name[128];
+			snprintf(name, sizeof(name), "BM_Fault/%s/%d", pager_name(*a), frames);
+			FaultBench *bench = setup_faults(*a, frames);
+			unsigned long long int max_iterations = (*a == 'o') ? BENCH_MAX_OPT_FAULTS : ~0ULL;
+			results.push_back(measure(name, run_faults, bench, min_time, max_iterations));
+			teardown_faults(bench);
+		}
+	}
+
+	if(trace != NULL) {
+		int null_fd = open("/dev/null", O_WRONLY);
+		for(const char *a = algos; *a != '\0'; a++) {
+			for(int frames = 16; frames <= max_sim_frames; frames *= 16) {
+				InputFile input(BENCH_PAGE_BITS);
+				input.openInputFile((char*)trace);
+				input.initProcess();
+
+				SimulateBench bench;
+				bench.input = &input;
+				memset(&bench.config, 0, sizeof(bench.config));
+				bench.config.algo = *a;
+				bench.config.frame_limit = frames;
+				bench.config.vpage_bits = BENCH_PAGE_BITS;
+				bench.config.output_fd = null_fd;
+				bench.config.random_table = &random_table;
+				bench.config.partition = -1;
+				bench.config.O_flag = bench.config.S_flag = pipeline;
+				bench.num_stages = 1;
+
+				//the first simulation counts the commands and lets OPT compute next uses
+				run_simulations(&bench, 1);
+
+				char name[128];
+				if(!pipeline) {
+					snprintf(name, sizeof(name), "BM_Simulate/%s/%d", pager_name(*a), frames);
+					results.push_back(measure(name, run_simulations, &bench, min_time, ~0ULL));
+					continue;
+				}
+				for(bench.num_stages = 1; bench.num_stages <= 3; bench.num_stages += 2) {
+					snprintf(name, sizeof(name), "BM_Pipeline/%s/%d/j%d", pager_name(*a), frames, bench.num_stages);
+					results.push_back(measure(name, run_simulations, &bench, min_time, ~0ULL));
+				}
+			}
+		}
+		close(null_fd);
+	}
+
+	if(json != NULL && !write_json(json, argv[0], min_time, results)) return 1;
+	return 0;
+}
@@ -0,0 +1,297 @@
+/*
+	Module Name: pagerbench.cpp
+	Description: Benchmarks fault handling throughput of the NRU, Clock and Aging pagers at 		large frame counts. Every frame is mapped and between two faults a number of random frames 		are referenced or modified, as simulate() would do. A second benchmark compares Second 		Chance with its original std::list implementation on hot working sets, where most frames 		are referenced again before the hand comes back. Usage: ./pagerbench [max_frames]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <list>
+#include "../pager.h"
+
+
+/**************************** Global Variables ****************************/
+Process **processes; //holds all the processes owning the mapped pages
+int num_processes; //total number of processes
+Frame *frame_table; //holds all the frames
+int frame_limit; //memory size
+RandomTable random_table; //random numbers, generated instead of loaded from an rfile
+RandomGenerator random_numbers(&random_table); //random numbers used by pagers and benchmark
+
+
+int myrandom(int size) {
+	return random_numbers.myrandom(size);
+}
+
+
+void generate_random_numbers(int size) {
+	/*
+		Function Name: generate_random_numbers
+		Arguments:
+			int size: number of random numbers
+		Returns: void
+		Description: fills the random numbers with a linear congruential generator so the 		benchmark does not need an rfile
+	*/
+	unsigned int seed = 12345;
+	random_table.size = size;
+	random_table.numbers = new int[size];
+	for(int i = 0; i < size; i++) {
+		seed = seed*1103515245 + 12345;
+		random_table.numbers[i] = seed >> 1;
+	}
+}
+
+
+class ListSecondChancePager : public Pager {
+	/*
+		Class Name: ListSecondChancePager
+		Description: original Second Chance pager rotating a std::list, kept for comparison
+	*/
+private:
+	std::list<Frame*> second_chance_list;
+
+public:
+	ListSecondChancePager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random) {
+		for(int i = 0; i < frame_limit; i++) {
+			second_chance_list.push_back(&frame_table[i]);
+		}
+	}
+
+	Frame* determine_victim_frame() {
+		Frame *frame = second_chance_list.front();
+		while(frame->pte->referenced) {
+			frame->pte->referenced = 0;
+			second_chance_list.push_back(frame);
+			second_chance_list.pop_front();
+			frame = second_chance_list.front();
+		}
+		second_chance_list.pop_front();
+		second_chance_list.push_back(frame);
+		return frame;
+	}
+};
+
+
+class ScalarClockPager : public Pager {
+	/*
+		Class Name: ScalarClockPager
+		Description: Clock pager looking at one frame at a time, reference for ClockPager
+	*/
+private:
+	int ind;
+	ReferencedBitmap referenced;
+
+public:
+	ScalarClockPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random), referenced(frame_limit) {
+		ind = 0;
+	}
+
+	Frame* determine_victim_frame() {
+		int victim = referenced.advance_scalar(ind);
+		ind = (victim+1)%frame_limit;
+		return &frame_table[victim];
+	}
+
+	void reference_frame(Frame *frame) {
+		referenced.set(frame->frame_number);
+	}
+};
+
+
+double now() {
+	/*
+		Function Name: now
+		Returns: double - monotonic time in seconds
+		Description: reads the monotonic clock
+	*/
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+
+void setup(int frames) {
+	/*
+		Function Name: setup
+		Arguments:
+			int frames: number of frames to be simulated
+		Returns: void
+		Description: creates enough processes to map every frame to a distinct page
+	*/
+	frame_limit = frames;
+	num_processes = (frames + 63)/64;
+	processes = (Process**)malloc(sizeof(Process*)*num_processes);
+	for(int i = 0; i < num_processes; i++) {
+		processes[i] = new Process(i, 6);
+	}
+
+	frame_table = (Frame*)malloc(sizeof(Frame)*frame_limit);
+	for(int i = 0; i < frame_limit; i++) {
+		PTE *pte = processes[i/64]->page_table.populate(i%64);
+		pte->valid = 1;
+		pte->frame_assigned = 1;
+		pte->referenced = 1;
+		frame_table[i].frame_number = i;
+		frame_table[i].process_id = i/64;
+		frame_table[i].page_number = i%64;
+		frame_table[i].pte = pte;
+	}
+}
+
+
+void teardown() {
+	/*
+		Function Name: teardown
+		Returns: void
+		Description: releases everything allocated by setup
+	*/
+	for(int i = 0; i < num_processes; i++) {
+		delete processes[i];
+	}
+	free(processes);
+	free(frame_table);
+}
+
+
+double run(char algo, int frames, int faults, int touches) {
+	/*
+		Function Name: run
+		Arguments:
+			char algo: pager to benchmark, 'n', 'c' or 'a'
+			int frames: number of frames
+			int faults: number of faults to be handled
+			int touches: number of frames referenced between two faults
+		Returns: double - faults handled per second
+		Description: handles faults with the given pager and measures throughput
+	*/
+	setup(frames);
+	Pager *pager;
+	if(algo == 'n') {
+		pager = new NRUPager(frame_table, frame_limit, &random_numbers);
+	} else if(algo == 'c') {
+		pager = new ClockPager(frame_table, frame_limit, &random_numbers);
+	} else {
+		pager = new AgingPager(frame_table, frame_limit, &random_numbers);
+	}
+
+	//every frame was referenced when it was mapped
+	for(int i = 0; i < frame_limit; i++) {
+		pager->reference_frame(&frame_table[i]);
+	}
+
+	double start = now();
+	for(int i = 0; i < faults; i++) {
+		Frame *frame = pager->determine_victim_frame();
+		frame->pte->referenced = 1;
+		frame->pte->modified = 0;
+		pager->reference_frame(frame);
+		for(int k = 0; k < touches; k++) {
+			Frame *touched = &frame_table[myrandom(frame_limit)];
+			touched->pte->referenced = 1;
+			if(k & 1) touched->pte->modified = 1;
+			pager->reference_frame(touched);
+		}
+	}
+	double elapsed = now() - start;
+
+	delete pager;
+	teardown();
+	return faults/elapsed;
+}
+
+
+double run_hot(char algo, int frames, int faults, int cold_period, unsigned long int *checksum) {
+	/*
+		Function Name: run_hot
+		Arguments:
+			char algo: pager to benchmark, 'l' for the std::list Second Chance, 'k' for the 			scalar Clock, 's' or 'c'
+			int frames: number of frames
+			int faults: number of faults to be handled
+			int cold_period: one frame in cold_period holds a cold page, the others are hot
+			unsigned long int *checksum: set to sum of victims, equal for all pagers
+		Returns: double - faults handled per second
+		Description: handles faults on a hot working set. Hot frames the hand cleared are 		referenced again before the next fault, so every fault passes about cold_period 		referenced frames before it finds a cold one. All pagers see frames in frame 		number order, so the hand is one past the previous victim.
+	*/
+	setup(frames);
+	Pager *pager;
+	if(algo == 'l') {
+		pager = new ListSecondChancePager(frame_table, frame_limit, &random_numbers);
+	} else if(algo == 'k') {
+		pager = new ScalarClockPager(frame_table, frame_limit, &random_numbers);
+	} else if(algo == 's') {
+		pager = new SecondChancePager(frame_table, frame_limit, &random_numbers);
+	} else {
+		pager = new ClockPager(frame_table, frame_limit, &random_numbers);
+	}
+	for(int i = 0; i < frame_limit; i++) {
+		frame_table[i].pte->referenced = (i % cold_period != 0);
+		if(frame_table[i].pte->referenced) pager->reference_frame(&frame_table[i]);
+	}
+
+	int hand = 0;
+	*checksum = 0;
+	double start = now();
+	for(int i = 0; i < faults; i++) {
+		Frame *frame = pager->determine_victim_frame();
+		*checksum += frame->frame_number;
+
+		//hot frames passed by the hand are referenced again, the new page is not
+		for(int f = hand; f != frame->frame_number; f = (f + 1 == frame_limit) ? 0 : f + 1) {
+			frame_table[f].pte->referenced = 1;
+			pager->reference_frame(&frame_table[f]);
+		}
+		frame->pte->referenced = 0;
+		hand = (frame->frame_number + 1 == frame_limit) ? 0 : frame->frame_number + 1;
+	}
+	double elapsed = now() - start;
+
+	delete pager;
+	teardown();
+	return faults/elapsed;
+}
+
+
+int main(int argc, char *argv[]) {
+	/*
+		Function Name: main
+		Arguments:
+			int argc: number of command line arguments
+			char *argv[]: string array containing all the command line arguments
+		Returns: int: program exit status
+		Description: runs every pager at increasing frame counts and prints faults per second
+	*/
+	int max_frames = (argc > 1) ? atoi(argv[1]) : (1 << 20);
+	generate_random_numbers(40000);
+	const char algos[] = {'n', 'c', 'a'};
+	const char *names[] = {"NRU", "Clock", "Aging"};
+
+	printf("%-6s %10s %14s\n", "pager", "frames", "faults/s");
+	for(int a = 0; a < 3; a++) {
+		for(int frames = 1024; frames <= max_frames; frames *= 4) {
+			//keep the amount of frame table work roughly constant
+			int faults = 200000000/frames;
+			if(faults < 50) faults = 50;
+			double rate = run(algos[a], frames, faults, 64);
+			printf("%-6s %10d %14.0f\n", names[a], frames, rate);
+		}
+	}
+
+	const char hot_algos[] = {'l', 's', 'k', 'c'};
+	const char *hot_names[] = {"SC-list", "SC", "Clock-1", "Clock"};
+	printf("\nhot working set\n");
+	printf("%-8s %10s %8s %14s\n", "pager", "frames", "hot", "faults/s");
+	for(int frames = 1024; frames <= max_frames; frames *= 32) {
+		for(int cold_period = 16; cold_period <= 256; cold_period *= 16) {
+			unsigned long int reference = 0;
+			for(int a = 0; a < 4; a++) {
+				unsigned long int checksum;
+				double rate = run_hot(hot_algos[a], frames, 2000000, cold_period, &checksum);
+				printf("%-8s %10d %7.1f%% %14.0f\n", hot_names[a], frames, 100.0 - 100.0/cold_period, rate);
+
+				//all of them must pick the same victims
+				if(a == 0) reference = checksum;
+				if(checksum != reference) printf("%s picked different victims\n", hot_names[a]);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+	Module Name: readerbench.cpp
+	Description: Benchmarks reading of commands from a text input file. Compares the original 		fstream/getline/sscanf reader with the streaming reader of readinput.cpp and reports lines 		per second for both. Usage: ./readerbench <inputfile> [repetitions]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fstream>
+#include "../readinput.h"
+
+
+double now() {
+	/*
+		Function Name: now
+		Returns: double - monotonic time in seconds
+		Description: reads the monotonic clock
+	*/
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+
+unsigned long int legacy_read(char *filename, long int *checksum) {
+	/*
+		Function Name: legacy_read
+		Arguments:
+			char *filename: path to input file
+			long int *checksum: accumulates command arguments so work is not optimized away
+		Returns: unsigned long int - number of lines read
+		Description: reads all lines the way the original getNextLine() and simulate() did, 		one heap allocated line and one sscanf per command
+	*/
+	std::fstream file(filename, std::ios_base::in);
+	unsigned long int lines = 0;
+	char cmd;
+	int cmd_num;
+
+	while(true) {
+		char *line = new char[100];
+		if(!file.getline(line, 100)) {
+			delete[] line;
+			break;
+		}
+		if(strlen(line) == 0 || line[0] == '#') {
+			delete[] line;
+			continue;
+		}
+		sscanf(line, "%c %d", &cmd, &cmd_num);
+		*checksum += cmd + cmd_num;
+		lines++;
+		delete[] line;
+	}
+	return lines;
+}
+
+
+unsigned long int streaming_read(char *filename, long int *checksum) {
+	/*
+		Function Name: streaming_read
+		Arguments:
+			char *filename: path to input file
+			long int *checksum: accumulates command arguments so work is not optimized away
+		Returns: unsigned long int - number of lines read
+		Description: reads all lines through the streaming reader of readinput.cpp. The 		process section is counted as lines too so both readers do the same work.
+	*/
+	Command command;
+	unsigned long int lines = 0;
+
+	InputFile input(6);
+	input.openInputFile(filename);
+	input.initProcess();
+	for(int i = 0; i < input.num_processes; i++) {
+		lines += 1 + input.processes[i]->vmas.size();
+	}
+	lines++;
+
+	while(input.getNextCommand(&command)) {
+		*checksum += command.cmd + command.num;
+		lines++;
+	}
+	return lines;
+}
+
+
+int main(int argc, char *argv[]) {
+	/*
+		Function Name: main
+		Arguments:
+			int argc: number of command line arguments
+			char *argv[]: string array containing all the command line arguments
+		Returns: int: program exit status
+		Description: runs both readers and prints lines per second
+	*/
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <inputfile> [repetitions]\n", argv[0]);
+		return 1;
+	}
+	int reps = (argc > 2) ? atoi(argv[2]) : 3;
+	long int checksum = 0;
+	double best_legacy = 1e30, best_streaming = 1e30;
+	unsigned long int lines = 0;
+
+	for(int r = 0; r < reps; r++) {
+		double start = now();
+		lines = legacy_read(argv[1], &checksum);
+		double elapsed = now() - start;
+		if(elapsed < best_legacy) best_legacy = elapsed;
+
+		start = now();
+		streaming_read(argv[1], &checksum);
+		elapsed = now() - start;
+		if(elapsed < best_streaming) best_streaming = elapsed;
+	}
+
+	printf("lines: %lu (checksum %ld)\n", lines, checksum);
+	printf("before (fstream + sscanf): %12.0f lines/s\n", lines/best_legacy);
+	printf("after (streaming read(2)): %12.0f lines/s\n", lines/best_streaming);
+	printf("speedup: %.2fx\n", best_legacy/best_streaming);
+	return 0;
+}
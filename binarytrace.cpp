@@ -0,0 +1,155 @@
+/*
+	Module Name: binarytrace.cpp
+	Description: designed to replay binary traces. The trace file is memory mapped and commands 		are decoded in place, so no allocation or parsing is done per command.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "readinput.h"
+#include "binarytrace.h"
+
+
+bool InputFile::openBinaryTrace(char *filename) {
+	/*
+		Function Name: openBinaryTrace
+		Arguments:
+			char *filename: path to input file
+		Returns: bool - true if file is a binary trace and was mapped, false otherwise
+		Description: memory maps the input file if it starts with the binary trace magic number
+	*/
+	struct stat st;
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) return false;
+
+	//a file smaller than the header can not be a binary trace
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceHeader)) {
+		close(fd);
+		return false;
+	}
+
+	uint32_t magic = 0;
+	if(read(fd, &magic, sizeof(magic)) != sizeof(magic) || magic != TRACE_MAGIC) {
+		close(fd);
+		return false;
+	}
+
+	void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+
+	//commands are read strictly in order
+	madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+	trace_base = (const char*)base;
+	trace_size = st.st_size;
+	return true;
+}
+
+
+void InputFile::initProcessBinary() {
+	/*
+		Function Name: initProcessBinary
+		Returns: void
+		Description: initializes processes and their VMAs from the process section of the 		binary trace
+	*/
+	const TraceHeader *header = (const TraceHeader*)trace_base;
+	if(header->version != TRACE_VERSION && header->version != TRACE_VERSION_NO_SHARED) {
+		fprintf(stderr, "unsupported binary trace version %u\n", header->version);
+		exit(1);
+	}
+
+	//the process section lies between the header and the commands, every word read from it
+	//is checked against its end so a corrupt header can not read past the mapping
+	uint64_t offset = header->commands_offset;
+	if(offset < sizeof(TraceHeader) || offset > trace_size || offset % sizeof(uint32_t) != 0) {
+		fprintf(stderr, "binary trace has an invalid command offset\n");
+		exit(1);
+	}
+	const uint32_t *word = (const uint32_t*)(trace_base + sizeof(TraceHeader));
+	const uint32_t *section_end = (const uint32_t*)(trace_base + offset);
+
+	//every process takes at least the word of its number of VMAs
+	if(header->num_processes > (uint64_t)(section_end - word)) {
+		fprintf(stderr, "binary trace has a corrupt process section\n");
+		exit(1);
+	}
+
+	//initialize list of all processes
+	num_processes = header->num_processes;
+	processes = (Process**)malloc(sizeof(Process*)*num_processes);
+
+	int vma_words = (header->version == TRACE_VERSION_NO_SHARED) ? 4 : 5;
+	for(int i = 0; i < num_processes; i++) {
+		processes[i] = new Process(i, vpage_bits);
+
+		if(word >= section_end) {
+			fprintf(stderr, "binary trace has a corrupt process section\n");
+			exit(1);
+		}
+		uint32_t num_vmas = *word++;
+		if(num_vmas > (uint64_t)(section_end - word)/vma_words) {
+			fprintf(stderr, "binary trace has a corrupt process section\n");
+			exit(1);
+		}
+		for(uint32_t k = 0; k < num_vmas; k++) {
+			VMA vma;
+			vma.start_page = word[0];
+			vma.end_page = word[1];
+			vma.write_protected = word[2];
+			vma.file_mapped = word[3];
+			vma.shared = (vma_words == 5) ? word[4] : 0;
+			processes[i]->vmas.push_back(vma);
+			word += vma_words;
+		}
+
+	}
+
+	//locate the command section
+	trace_commands = section_end;
+	trace_num_commands = header->num_commands;
+	trace_curr = 0;
+
+	//guard against truncated traces
+	if(trace_num_commands > (trace_size - offset)/sizeof(uint32_t)) {
+		fprintf(stderr, "binary trace is truncated\n");
+		exit(1);
+	}
+}
+
+
+int InputFile::getNextBinaryCommands(Command *commands, int max) {
+	/*
+		Function Name: getNextBinaryCommands
+		Arguments:
+			Command *commands: filled with the decoded commands
+			int max: maximum number of commands to be decoded
+		Returns: int - number of commands decoded, 0 if trace is exhausted
+		Description: decodes the next packed commands directly from the mapped trace
+	*/
+	uint64_t remaining = trace_num_commands - trace_curr;
+	int count = (remaining < (uint64_t)max) ? (int)remaining : max;
+	const uint32_t *word = trace_commands + trace_curr;
+	for(int i = 0; i < count; i++) {
+		commands[i].cmd = decode_op(word[i]);
+		commands[i].num = decode_arg(word[i]);
+	}
+	trace_curr += count;
+	return count;
+}
+
+
+void InputFile::rewindBinaryTrace() {
+	/*
+		Function Name: rewindBinaryTrace
+		Returns: void
+		Description: restarts replay from the first command
+	*/
+	trace_curr = 0;
+}
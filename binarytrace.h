@@ -0,0 +1,89 @@
+/*
+	Module Name: binarytrace.h
+	Description: Defines the layout of the binary trace format. A binary trace contains a 		fixed header, the process/VMA section and then one packed 32 bit word per command.
+
+	Layout (all fields little endian, 4 byte aligned):
+		TraceHeader
+		for each process: uint32 num_vmas, followed by num_vmas x (start, end, write_protected, file_mapped, shared) as uint32
+		num_commands x uint32 packed command
+
+	Version 1 traces have no shared field, they are still read.
+*/
+#include <stdint.h>
+
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#define TRACE_MAGIC 0x42554d4d //"MMUB" when read as bytes
+#define TRACE_VERSION 2
+#define TRACE_VERSION_NO_SHARED 1 //VMAs have 4 fields
+
+//a command is packed as opcode in upper 4 bits and operand in lower 28 bits
+#define TRACE_OP_SHIFT 28
+#define TRACE_ARG_MASK 0x0FFFFFFF
+
+#define TRACE_OP_CONTEXT 0
+#define TRACE_OP_READ 1
+#define TRACE_OP_WRITE 2
+#define TRACE_OP_FORK 3
+#define TRACE_OP_EXEC 4
+#define TRACE_OP_EXIT 5
+
+struct TraceHeader {
+	/*
+		Struct Name: TraceHeader
+		Description: defines the fixed size header at the start of a binary trace
+	*/
+	uint32_t magic; //always TRACE_MAGIC
+	uint32_t version; //format version, TRACE_VERSION
+	uint32_t num_processes; //number of process sections following the header
+	uint32_t reserved; //padding, always 0
+	uint64_t num_commands; //number of packed commands
+	uint64_t commands_offset; //byte offset of first packed command from start of file
+};
+
+inline uint32_t encode_command(char cmd, int num) {
+	/*
+		Function Name: encode_command
+		Arguments:
+			char cmd: command character 'c', 'r', 'w', 'f', 'e' or 'x'
+			int num: argument of the command
+		Returns: uint32_t - packed command
+		Description: packs a command into its binary representation, unknown commands are 		packed as writes as the simulator treats them
+	*/
+	uint32_t op;
+	switch(cmd) {
+	case 'c': op = TRACE_OP_CONTEXT; break;
+	case 'r': op = TRACE_OP_READ; break;
+	case 'f': op = TRACE_OP_FORK; break;
+	case 'e': op = TRACE_OP_EXEC; break;
+	case 'x': op = TRACE_OP_EXIT; break;
+	default: op = TRACE_OP_WRITE; break;
+	}
+	return (op << TRACE_OP_SHIFT) | ((uint32_t)num & TRACE_ARG_MASK);
+}
+
+inline char decode_op(uint32_t word) {
+	/*
+		Function Name: decode_op
+		Arguments:
+			uint32_t word: packed command
+		Returns: char - command character 'c', 'r', 'w', 'f', 'e' or 'x'
+		Description: extracts command character from a packed command
+	*/
+	static const char ops[16] = {'c', 'r', 'w', 'f', 'e', 'x', '?', '?', '?', '?', '?', '?', '?', '?', '?', '?'};
+	return ops[word >> TRACE_OP_SHIFT];
+}
+
+inline int decode_arg(uint32_t word) {
+	/*
+		Function Name: decode_arg
+		Arguments:
+			uint32_t word: packed command
+		Returns: int - argument of the command
+		Description: extracts argument from a packed command
+	*/
+	return (int)(word & TRACE_ARG_MASK);
+}
+
+#endif
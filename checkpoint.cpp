@@ -0,0 +1,205 @@
+/*
+	Module Name: checkpoint.cpp
+	Description: Saves the complete state of a simulation to a snapshot file and continues a 		simulation from one. A snapshot holds the options it was taken with, the position in 		input file and in output, and the state of processes, frame table, pager and random 		numbers. Continuing from it gives the same output as the simulation that wrote it.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "pager.h"
+#include "simulator.h"
+
+
+/*************************** imported from readinput.cpp ***************************/
+extern void clearPageTable(Process *process);
+
+
+struct SnapshotHeader {
+	/*
+		Struct Name: SnapshotHeader
+		Description: defines the fixed size start of a snapshot, used to check that a 		snapshot belongs to the simulation it is loaded into
+	*/
+	uint32_t magic; //SNAPSHOT_MAGIC
+	uint32_t version; //SNAPSHOT_VERSION
+	char algo; //algorithm of simulation
+	int32_t frame_limit; //memory size
+	int32_t vpage_bits; //width of virtual address space in pages
+	int32_t num_processes; //total number of processes
+	uint64_t input_size; //size of input file
+	int64_t input_mtime; //last modification of input file, in nanoseconds
+	TLBConfig tlb; //geometry of TLB
+	int32_t huge_pages; //pages per huge page, 0 for no huge pages
+	KswapdConfig kswapd; //simulated time and kswapd
+};
+
+
+void Simulator::state(Snapshot &snapshot) {
+	/*
+		Function Name: state
+		Arguments:
+			Snapshot &snapshot: snapshot the state is saved to or loaded from
+		Returns: void
+		Description: transfers everything that changes while commands are simulated. Frames 		keep the page they hold, the PTE pointers are found again from it on load. Fork, 		exec and exit change the VMAs, so page tables are cleared before theirs are loaded.
+	*/
+	snapshot.field(curr_proc);
+	snapshot.field(started);
+	snapshot.field(instr_num);
+	snapshot.field(ctx_switches);
+	snapshot.field(reads);
+	snapshot.field(writes);
+	snapshot.field(random.curr);
+	snapshot.field(sharing);
+
+	for(int i = 0; i < num_processes; i++) {
+		if(snapshot.loading) clearPageTable(processes[i]);
+		processes[i]->state(snapshot);
+	}
+
+	allocator.state(snapshot);
+	if(huge != NULL) huge->state(snapshot);
+	for(int i = 0; i < frame_limit; i++) {
+		snapshot.field(frame_table[i].process_id);
+		snapshot.field(frame_table[i].page_number);
+		snapshot.field(frame_table[i].refcount);
+		snapshot.field(frame_table[i].next_mapping);
+		snapshot.field(frame_table[i].cow);
+	}
+	rmap.state(snapshot, processes);
+	pager->state(snapshot);
+	if(tlb != NULL) tlb->state(snapshot, processes);
+	if(disk != NULL) {
+		disk->state(snapshot);
+		fault_latency.state(snapshot);
+		snapshot.field(io_wait);
+		snapshot.field(background_cost);
+		snapshot.field(kswapd_wakeups);
+		snapshot.field(kswapd_batches);
+		snapshot.field(kswapd_reclaimed);
+		snapshot.field(kswapd_written);
+		snapshot.field(direct_reclaims);
+		snapshot.field(writeback_stalls);
+	}
+
+	if(!snapshot.loading || snapshot.failed) return;
+	page_table = started ? &processes[curr_proc]->page_table : NULL;
+	for(int i = 0; i < frame_limit; i++) {
+		Frame *frame = &frame_table[i];
+		frame->pte = (frame->process_id == -1) ? NULL : processes[frame->process_id]->page_table.lookup(frame->page_number);
+	}
+}
+
+
+bool Simulator::save_checkpoint(InputFile *input, const char *path) {
+	/*
+		Function Name: save_checkpoint
+		Arguments:
+			InputFile *input: input file being simulated
+			const char *path: snapshot file
+		Returns: bool - false if snapshot could not be written
+		Description: output is flushed first, so the snapshot records how much of it is 		done. The snapshot is written next to path and renamed over it, a crash while 		writing leaves the previous snapshot intact.
+	*/
+	out.flush();
+
+	char temp[4096];
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	FILE *file = fopen(temp, "wb");
+	if(file == NULL) {
+		perror(temp);
+		return false;
+	}
+
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.algo = algo;
+	header.frame_limit = frame_limit;
+	header.vpage_bits = input->vpage_bits;
+	header.num_processes = num_processes;
+	header.input_size = input->file_size;
+	header.input_mtime = input->file_mtime;
+	header.tlb = tlb_config;
+	header.huge_pages = (huge != NULL) ? huge->size : 0;
+	header.kswapd = kswapd_config;
+	InputPosition position = input->tellInput();
+	unsigned long long int output_done = output_offset + out.bytes_written;
+
+	Snapshot snapshot(file, false);
+	snapshot.field(header);
+	snapshot.field(position);
+	snapshot.field(output_done);
+	state(snapshot);
+
+	bool ok = !snapshot.failed && fflush(file) == 0 && fsync(fileno(file)) == 0;
+	ok = (fclose(file) == 0) && ok;
+	if(!ok || rename(temp, path) != 0) {
+		perror(path);
+		return false;
+	}
+	return true;
+}
+
+
+bool Simulator::load_checkpoint(InputFile *input, const char *path) {
+	/*
+		Function Name: load_checkpoint
+		Arguments:
+			InputFile *input: input file being simulated, moved to the position of snapshot
+			const char *path: snapshot file
+		Returns: bool - false if snapshot could not be read or belongs to another simulation
+		Description: must be called on a simulator that has not simulated any command. 		output_offset is set to the output written before the snapshot was taken.
+	*/
+	FILE *file = fopen(path, "rb");
+	if(file == NULL) {
+		perror(path);
+		return false;
+	}
+
+	SnapshotHeader header;
+	InputPosition position;
+	Snapshot snapshot(file, true);
+	snapshot.field(header);
+	if(snapshot.failed || header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+		fprintf(stderr, "%s is not a snapshot\n", path);
+		fclose(file);
+		return false;
+	}
+	if(header.algo != algo || header.frame_limit != frame_limit || header.vpage_bits != input->vpage_bits || header.num_processes != num_processes) {
+		fprintf(stderr, "%s was taken with -a%c -f%d -v%d and %d processes\n", path, header.algo, header.frame_limit, header.vpage_bits, header.num_processes);
+		fclose(file);
+		return false;
+	}
+	if(header.input_size != input->file_size || header.input_mtime != input->file_mtime) {
+		fprintf(stderr, "%s was taken of another input file, or of this one before it changed\n", path);
+		fclose(file);
+		return false;
+	}
+	TLBConfig &t = header.tlb;
+	if(t.l1_entries != tlb_config.l1_entries || t.l1_ways != tlb_config.l1_ways || t.l2_entries != tlb_config.l2_entries || t.l2_ways != tlb_config.l2_ways || t.flush_on_switch != tlb_config.flush_on_switch) {
+		fprintf(stderr, "%s was taken with another --tlb or --tlb-flush\n", path);
+		fclose(file);
+		return false;
+	}
+	if(header.huge_pages != ((huge != NULL) ? huge->size : 0)) {
+		fprintf(stderr, "%s was taken with another --huge\n", path);
+		fclose(file);
+		return false;
+	}
+	KswapdConfig &k = header.kswapd;
+	if(k.timed != kswapd_config.timed || k.io_latency != kswapd_config.io_latency || k.low != kswapd_config.low || k.high != kswapd_config.high || k.batch != kswapd_config.batch) {
+		fprintf(stderr, "%s was taken with another --kswapd or --io-latency\n", path);
+		fclose(file);
+		return false;
+	}
+
+	snapshot.field(position);
+	snapshot.field(output_offset);
+	state(snapshot);
+	fclose(file);
+	if(snapshot.failed) {
+		fprintf(stderr, "%s is truncated\n", path);
+		return false;
+	}
+
+	input->seekInput(position);
+	return true;
+}
@@ -1,18 +1,31 @@
 /*
 	Module Name: datastructures.h
-	Description: Contains definitions of PTE, Process and Frame.
+	Description: Contains definitions of PTE, PageTable, Frame, ReferencedBitmap, Process, ReverseMap, FenwickTree, LinkedLists and BitTree.
 */
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "output.h"
+#include "snapshot.h"
+#include "profile.h"
 
 #ifndef PTE_H
 #define PTE_H
 
+//width of frame index in PTE, decides the largest physical memory that can be simulated.
+//7 flag bits and 25 index bits keep a PTE in 32 bits, can be changed at compile time
+#ifndef PTE_FRAME_BITS
+#define PTE_FRAME_BITS 25
+#endif
+
+#define MAX_FRAMES (1 << PTE_FRAME_BITS) //largest supported frame count
+
 struct PTE {
 	/*
 		Struct Name: PTE
-		Description: defines a page table entry in with 14 bit address
+		Description: defines a page table entry with PTE_FRAME_BITS bit frame index
 	*/
 	unsigned int valid : 1; //whether it is a part of VMA
 	unsigned int write_protected: 1; //whether it is write protected
@@ -21,7 +34,304 @@ struct PTE {
 	unsigned int paged_out: 1; //whether it is paged out
 	unsigned int file_mapped: 1; //whether there is a file mapped to this page
 	unsigned int frame_assigned: 1; //whether this page is loaded into physical frame
-	unsigned int frame_index: 7; //address in frame table, 7 bits to address 128 frames.
+	unsigned int frame_index: PTE_FRAME_BITS; //address in frame table
+};
+
+#endif
+
+#ifndef VMA_H
+#define VMA_H
+
+struct VMA {
+	/*
+		Struct Name: VMA
+		Description: defines a virtual memory area as specified in input file
+	*/
+	int start_page; //first page of the area
+	int end_page; //last page of the area (inclusive)
+	int write_protected; //whether pages of area are write protected
+	int file_mapped; //whether pages of area are file mapped
+	int shared; //whether pages of area stay shared with children after fork, writes are not copied
+};
+
+#endif
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+struct Command {
+	/*
+		Struct Name: Command
+		Description: defines a decoded input command, independent of the trace format
+	*/
+	char cmd; //'c', 'r', 'w', 'f' (fork), 'e' (exec) or 'x' (exit)
+	int num; //process id for 'c' and of child for 'f', page number for 'r' and 'w', process whose VMAs are loaded for 'e', exit status for 'x'
+};
+
+#define NO_NEXT_USE UINT64_MAX //next use of a page that is not referenced again
+
+#endif
+
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#define PT_LEVEL_BITS 9 //number of page bits resolved by each level of the page table
+#define PT_LEVEL_SIZE (1 << PT_LEVEL_BITS) //entries in each node of the page table
+#define MAX_VPAGE_BITS 28 //largest supported virtual address width in pages
+
+class PageTable {
+	/*
+		Class Name: PageTable
+		Description: defines a multi level page table. Every level resolves PT_LEVEL_BITS 		of the page number, the top level resolves what is left. Nodes are only allocated 		for parts of address space that are populated, holes cost no memory and are read as 		invalid PTEs.
+	*/
+private:
+	void *root; //top level node, a PTE array if there is only one level
+	int levels; //number of levels
+	unsigned int num_pages; //size of virtual address space in pages
+
+	static PTE *invalid_pte() {
+		/*
+			Function Name: invalid_pte
+			Returns:
+				PTE*: shared PTE returned for pages that are not populated
+			Description: every field of this PTE is 0, so it reads as not being part of VMA. 			It is never written as simulator only updates valid PTEs.
+		*/
+		static PTE pte = {0, 0, 0, 0, 0, 0, 0, 0};
+		return &pte;
+	}
+
+	unsigned int node_size(int depth) {
+		/*
+			Function Name: node_size
+			Arguments:
+				int depth: depth of node, 0 being the top level
+			Returns:
+				unsigned int: number of entries in nodes at depth
+			Description: all levels but the top one are full nodes
+		*/
+		if(depth > 0) return PT_LEVEL_SIZE;
+		return ((num_pages - 1) >> (PT_LEVEL_BITS*(levels - 1))) + 1;
+	}
+
+	void free_node(void *node, int depth) {
+		/*
+			Function Name: free_node
+			Arguments:
+				void *node: node to be freed along with its children
+				int depth: depth of node
+			Returns: void
+			Description: releases memory of a sub tree
+		*/
+		if(node == NULL) return;
+		if(depth < levels - 1) {
+			for(unsigned int i = 0; i < node_size(depth); i++) {
+				free_node(((void**)node)[i], depth + 1);
+			}
+		}
+		free(node);
+	}
+
+public:
+	PageTable(int vpage_bits) {
+		/*
+			Function Name: constructor
+			Arguments:
+				int vpage_bits: width of virtual address space in pages
+			Description: creates an empty page table for 2^vpage_bits pages
+		*/
+		num_pages = 1u << vpage_bits;
+		levels = 1;
+		while(levels*PT_LEVEL_BITS < vpage_bits) levels++;
+		root = NULL;
+	}
+
+	~PageTable() {
+		free_node(root, 0);
+	}
+
+	unsigned int size() {
+		/*
+			Function Name: size
+			Returns:
+				unsigned int: number of pages in virtual address space
+		*/
+		return num_pages;
+	}
+
+	PTE *lookup(unsigned int page) {
+		/*
+			Function Name: lookup
+			Arguments:
+				unsigned int page: page number
+			Returns:
+				PTE*: PTE of page, a shared invalid PTE if page is not populated
+			Description: walks the levels of page table down to the PTE of page
+		*/
+		if(page >= num_pages) return invalid_pte();
+		void *node = root;
+		for(int depth = 0; depth < levels - 1; depth++) {
+			if(node == NULL) return invalid_pte();
+			unsigned int ind = (page >> (PT_LEVEL_BITS*(levels - 1 - depth))) & (PT_LEVEL_SIZE - 1);
+			node = ((void**)node)[ind];
+		}
+		if(node == NULL) return invalid_pte();
+		return &((PTE*)node)[page & (PT_LEVEL_SIZE - 1)];
+	}
+
+	PTE *populate(unsigned int page) {
+		/*
+			Function Name: populate
+			Arguments:
+				unsigned int page: page number, less than size()
+			Returns:
+				PTE*: PTE of page
+			Description: walks the levels of page table down to the PTE of page, allocating 			the missing nodes on the way. New PTEs are all 0.
+		*/
+		void **slot = &root;
+		for(int depth = 0; depth < levels - 1; depth++) {
+			if(*slot == NULL) *slot = calloc(node_size(depth), sizeof(void*));
+			unsigned int ind = (page >> (PT_LEVEL_BITS*(levels - 1 - depth))) & (PT_LEVEL_SIZE - 1);
+			slot = &((void**)*slot)[ind];
+		}
+		if(*slot == NULL) *slot = calloc(levels == 1 ? num_pages : PT_LEVEL_SIZE, sizeof(PTE));
+		return &((PTE*)*slot)[page & (PT_LEVEL_SIZE - 1)];
+	}
+};
+
+#endif
+
+#ifndef FRAME_H
+#define FRAME_H
+
+struct Frame {
+	/*
+		Struct Name: Frame
+		Description: defines a single Frame. A frame is mapped by one PTE, or by several once 		fork shares it. The first mapping is kept in the frame itself, the others are chained 		through a ReverseMap. The PTE of the first mapping holds the referenced and modified 		bits of the whole frame, which are what the pagers look at. Pagers with a clock hand 		keep the referenced bit in a ReferencedBitmap instead.
+	*/
+	int frame_number;
+	int process_id; //to reverse map the process of first mapping, -1 if frame is free
+	int page_number; //to get the PTE of first mapping from the process page table
+	PTE *pte; //PTE of first mapping, saves the lookup through process
+	int refcount; //number of PTEs mapping the frame
+	int next_mapping; //entry of ReverseMap holding second mapping, -1 if there is none
+	bool cow; //whether a write through a mapping copies the page while refcount > 1
+};
+
+
+#endif
+
+#ifndef REFERENCED_BITMAP_H
+#define REFERENCED_BITMAP_H
+
+class ReferencedBitmap {
+	/*
+		Class Name: ReferencedBitmap
+		Description: packs the referenced bit of the page on every frame, one bit per frame. 		Kept by pagers with a clock hand from reference_frame(), and then it is the referenced 		bit of the frame: the bit in the PTE of the first mapping is not cleared with it. 		Page tables are printed from it and the simulator writes it to the PTE when the first 		mapping is removed. The hand finds the next unreferenced frame and clears the frames 		passed 64 frames at a time, without loading any PTE.
+	*/
+private:
+	std::vector<uint64_t> words; //bit f%64 of word f/64 is referenced bit of frame f
+	int frame_limit; //number of frames
+
+	void clear_range(int first, int last) {
+		/*
+			Function Name: clear_range
+			Arguments:
+				int first, last: frames passed by the hand, last exclusive, within one word
+			Returns: void
+			Description: clears the referenced bit of the frames with a single mask
+		*/
+		if(first == last) return;
+		uint64_t mask = (~0ULL << (first & 63)) & (~0ULL >> (63 - ((last - 1) & 63)));
+		words[first >> 6] &= ~mask;
+	}
+
+public:
+	ReferencedBitmap(int frame_limit) : words((frame_limit + 63)/64, 0) {
+		this->frame_limit = frame_limit;
+	}
+
+	void set(int f) {
+		/*
+			Function Name: set
+			Arguments:
+				int f: frame whose page was referenced
+			Returns: void
+		*/
+		words[f >> 6] |= 1ULL << (f & 63);
+	}
+
+	void clear(int f) {
+		/*
+			Function Name: clear
+			Arguments:
+				int f: frame whose page was freed
+			Returns: void
+		*/
+		words[f >> 6] &= ~(1ULL << (f & 63));
+	}
+
+	bool test(int f) const {
+		/*
+			Function Name: test
+			Arguments:
+				int f: frame number
+			Returns:
+				bool: referenced bit of frame
+		*/
+		return (words[f >> 6] >> (f & 63)) & 1;
+	}
+
+	int advance(int hand) {
+		/*
+			Function Name: advance
+			Arguments:
+				int hand: first frame to be looked at
+			Returns:
+				int: first frame from hand on, wrapping around, whose page is not referenced
+			Description: moves the hand to the next unreferenced frame and clears the 			referenced bit of every frame passed. A word of the bitmap is handled at once, 			the lowest clear bit is found with ctz.
+		*/
+		int last_word = (frame_limit - 1) >> 6;
+		uint64_t last_mask = ~0ULL >> (63 - ((frame_limit - 1) & 63)); //frames of last word
+		while(true) {
+			int w = hand >> 6;
+			uint64_t free = ~words[w] & (~0ULL << (hand & 63));
+			if(w == last_word) free &= last_mask;
+			if(free != 0) {
+				int victim = (w << 6) + __builtin_ctzll(free);
+				clear_range(hand, victim);
+				return victim;
+			}
+			int end = (w == last_word) ? frame_limit : (w + 1) << 6;
+			clear_range(hand, end);
+			hand = (end == frame_limit) ? 0 : end;
+		}
+	}
+
+	int advance_scalar(int hand) {
+		/*
+			Function Name: advance_scalar
+			Arguments:
+				int hand: first frame to be looked at
+			Returns:
+				int: same frame as advance()
+			Description: reference implementation of advance(), looks at one frame at a time
+		*/
+		while(test(hand)) {
+			clear(hand);
+			hand = (hand+1)%frame_limit;
+		}
+		return hand;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(words);
+	}
 };
 
 #endif
@@ -29,6 +339,22 @@ struct PTE {
 #ifndef PROCESS_H
 #define PROCESS_H
 
+//cost of translation with a TLB (tlb.h) on top of that of the reference, L1 hits are free
+#define TLB_L2_HIT_COST 5 //lookup in L2 after an L1 miss
+#define TLB_WALK_COST 30 //page walk after a miss in all levels
+#define TLB_SHOOTDOWN_COST 200 //invalidation of the entry of an unmapped page
+
+//cost of address spaces sharing pages
+#define FORK_COST 2000 //fork, besides the pages shared with the child
+#define SHARE_COST 30 //page in memory mapped into child by fork
+#define COW_COST 300 //copy of a page shared copy-on-write, besides its map
+#define EXEC_COST 1500 //exec, besides the pages unmapped
+#define EXIT_COST 1000 //exit, besides the pages unmapped
+
+//cost of huge pages (hugepage.h)
+#define PROMOTE_COST 500 //mapping a fully populated region as a huge page
+#define DEMOTE_COST 800 //splitting a huge page back into base pages
+
 class Process {
 	/*
 		Class Name: Process
@@ -36,76 +362,115 @@ class Process {
 	*/
 public:
 	int process_id; 
-	PTE **page_table; //pointers to PTE of all VMA Pages
+	PageTable page_table; //PTE of all VMA Pages
+	std::vector<VMA> vmas; //VMAs as specified in input file
 
 	//records all the stats for summarizing the performance
 	long unsigned int seg_p, seg_v, pin, pout, fin, fout, zero, unmaps, maps;
+	long unsigned int tlb_hits, tlb_l2_hits, tlb_walks, tlb_shootdowns; //translations, if there is a TLB
+	long unsigned int forks, execs, exits, shares, cows; //address space changes and pages shared by fork or copied on write
+	long unsigned int huge_maps, promotions, demotions, tlb_huge_hits; //pages mapped into huge page reservations and what became of them
 
-	Process(int process_id) {
+	Process(int process_id, int vpage_bits) : page_table(vpage_bits) {
 		/*
 			Function Name: constructor
 			Arguments:
 				int process_id: process id of the process. It is same as its index in 			global processes array
+				int vpage_bits: width of virtual address space in pages
 			Description: Initializes all the members of class
 		*/
 		this->process_id = process_id;
-		page_table = (PTE**)malloc(sizeof(PTE*)*64);
-		for(int i = 0; i < 64; i++) {
-			page_table[i] = (PTE*)malloc(sizeof(PTE));
-		}
 		seg_p = seg_v = pin = pout = fin = fout = zero = unmaps = maps = 0;
+		tlb_hits = tlb_l2_hits = tlb_walks = tlb_shootdowns = 0;
+		forks = execs = exits = shares = cows = 0;
+		huge_maps = promotions = demotions = tlb_huge_hits = 0;
 	}
 
-	void print_stats() {
+	void print_stats(OutputBuffer &out, bool tlb = false, bool sharing = false, bool huge = false) {
 		/*
 			Function Name: print_stats
+			Arguments:
+				OutputBuffer &out: output of the simulation
+				bool tlb: whether the TLB counters are appended
+				bool sharing: whether the fork, exec and exit counters are appended
+				bool huge: whether the huge page counters are appended
 			Description: prints the summary statistics in the format specified
 			Returns: void
 		*/
-		printf("PROC[%d]: U=%lu M=%lu I=%lu O=%lu FI=%lu FO=%lu Z=%lu SV=%lu SP=%lu\n", process_id, unmaps, maps, pin, pout, fin, fout, zero, seg_v,seg_p);
+		out.put("PROC["); out.put_int(process_id);
+		out.put("]: U="); out.put_uint(unmaps);
+		out.put(" M="); out.put_uint(maps);
+		out.put(" I="); out.put_uint(pin);
+		out.put(" O="); out.put_uint(pout);
+		out.put(" FI="); out.put_uint(fin);
+		out.put(" FO="); out.put_uint(fout);
+		out.put(" Z="); out.put_uint(zero);
+		out.put(" SV="); out.put_uint(seg_v);
+		out.put(" SP="); out.put_uint(seg_p);
+		if(tlb) {
+			out.put(" TLB: H="); out.put_uint(tlb_hits);
+			out.put(" H2="); out.put_uint(tlb_l2_hits);
+			out.put(" W="); out.put_uint(tlb_walks);
+			out.put(" SD="); out.put_uint(tlb_shootdowns);
+		}
+		if(sharing) {
+			out.put(" SHARE: F="); out.put_uint(forks);
+			out.put(" E="); out.put_uint(execs);
+			out.put(" X="); out.put_uint(exits);
+			out.put(" SH="); out.put_uint(shares);
+			out.put(" COW="); out.put_uint(cows);
+		}
+		if(huge) {
+			//maps of base pages are the ones not into a reservation
+			out.put(" HUGE: BM="); out.put_uint(maps - huge_maps);
+			out.put(" HM="); out.put_uint(huge_maps);
+			out.put(" P="); out.put_uint(promotions);
+			out.put(" D="); out.put_uint(demotions);
+			if(tlb) {
+				out.put(" HH="); out.put_uint(tlb_huge_hits);
+			}
+		}
+		out.put('\n');
 	}
 
-	void print_page_table() {
+	void print_page_table(OutputBuffer &out, const Frame *frame_table = NULL, const ReferencedBitmap *referenced = NULL) {
 		/*
 			Function Name: print_page_table
-			Description: print the page table of the process in the format specified
+			Arguments:
+				OutputBuffer &out: output of the simulation
+				const Frame *frame_table: frame table of simulator, only needed with referenced
+				const ReferencedBitmap *referenced: referenced bits kept by the pager, NULL if 				they are kept in the PTEs
+			Description: print the page table of the process in the format specified. The 			referenced bit of a page that is the first mapping of its frame is read from 			referenced if given
 			Returns: void
 		*/
-		printf("PT[%d]: ", process_id);
+		PROFILE_SCOPE("Process::print_page_table");
+		out.put("PT["); out.put_int(process_id); out.put("]: ");
 		PTE *pte;
-		for(int i = 0; i < 64; i++) {
-			pte = page_table[i];
+		for(unsigned int i = 0; i < page_table.size(); i++) {
+			pte = page_table.lookup(i);
 
 			//print the pte summary if it is in the physical memory
 			if(pte->valid && pte->frame_assigned)
 			{
-				printf("%d:", i);
-				if(pte->referenced) {
-					printf("R");
-				} else {
-					printf("-");
-				}
-				if(pte->modified) {
-					printf("M");
-				} else {
-					printf("-");
-				}
-				if(pte->paged_out) {
-					printf("S");
-				} else {
-					printf("-");
-				}
-				printf(" ");
+				out.put_uint(i);
+				out.put(':');
+				bool r = pte->referenced;
+				if(referenced != NULL && frame_table[pte->frame_index].pte == pte)
+					r = referenced->test(pte->frame_index);
+				out.put(r ? 'R' : '-');
+				out.put(pte->modified ? 'M' : '-');
+				out.put(pte->paged_out ? 'S' : '-');
+				out.put(' ');
 			} else {
 				//if not in physical memory and paged out then print #
 				if(pte->valid && pte->paged_out) {
-					printf("# ");
+					out.put("# ");
 				} else {
-					printf("* ");
+					out.put("* ");
 				}
 			}
 		}
-		printf("\n");
+		out.put('\n');
 	}
 
 	unsigned long int get_cost() {
@@ -115,25 +480,563 @@ public:
 			Returns: 
 				unsigned long int: cost incurred by this process
 		*/
-		return (maps+unmaps)*400+(pin+pout)*3000+(fin+fout)*2500+zero*150+seg_v*240+seg_p*300;
+		return (maps+unmaps)*400+(pin+pout)*3000+(fin+fout)*2500+zero*150+seg_v*240+seg_p*300+tlb_l2_hits*TLB_L2_HIT_COST+tlb_walks*TLB_WALK_COST+tlb_shootdowns*TLB_SHOOTDOWN_COST
+			+forks*FORK_COST+shares*SHARE_COST+cows*COW_COST+execs*EXEC_COST+exits*EXIT_COST+promotions*PROMOTE_COST+demotions*DEMOTE_COST;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+			Description: only the VMAs and the PTEs of their pages are saved, the other 			pages are never populated. Fork, exec and exit change the VMAs, so on load 			the page table must have been cleared by clearPageTable() beforehand
+		*/
+		snapshot.field(seg_p);
+		snapshot.field(seg_v);
+		snapshot.field(pin);
+		snapshot.field(pout);
+		snapshot.field(fin);
+		snapshot.field(fout);
+		snapshot.field(zero);
+		snapshot.field(unmaps);
+		snapshot.field(maps);
+		snapshot.field(tlb_hits);
+		snapshot.field(tlb_l2_hits);
+		snapshot.field(tlb_walks);
+		snapshot.field(tlb_shootdowns);
+		snapshot.field(forks);
+		snapshot.field(execs);
+		snapshot.field(exits);
+		snapshot.field(shares);
+		snapshot.field(cows);
+		snapshot.field(huge_maps);
+		snapshot.field(promotions);
+		snapshot.field(demotions);
+		snapshot.field(tlb_huge_hits);
+		snapshot.field(vmas);
+		for(int k = 0; k < (int)vmas.size(); k++) {
+			for(int j = vmas[k].start_page; j <= vmas[k].end_page; j++) {
+				snapshot.field(*page_table.populate(j));
+			}
+		}
 	}
 };
 
 
 #endif
 
-#ifndef FRAME_H
-#define FRAME_H
+#ifndef REVERSE_MAP_H
+#define REVERSE_MAP_H
 
-struct Frame {
+struct Mapping {
 	/*
-		Struct Name: Frame
-		Description: defines a single Frame
+		Struct Name: Mapping
+		Description: defines a mapping of a shared frame besides its first one
 	*/
-	int frame_number;
-	int process_id; //to reverse map the process
-	int page_number; //to get the PTE from the process page table
+	int process_id; //process of mapping, -1 if entry is free
+	int page_number; //page of mapping
+	PTE *pte; //PTE of mapping
+	int next; //entry of next mapping of same frame, or of next free entry, -1 if there is none
+};
+
+class ReverseMap {
+	/*
+		Class Name: ReverseMap
+		Description: defines the mappings of shared frames beyond their first one, as a chain 		per frame through a pool of entries. Finding all mappings of a frame, and removing 		one of them, is O(sharers) whatever the number of processes. Unshared frames, the 		common case, use no entry.
+	*/
+private:
+	std::vector<Mapping> entries; //pool of entries
+	int free_entry; //first free entry, -1 if there is none
+
+public:
+	ReverseMap() {
+		free_entry = -1;
+	}
+
+	Mapping &at(int m) {
+		return entries[m];
+	}
+
+	void add(Frame *frame, int process_id, int page_number, PTE *pte) {
+		/*
+			Function Name: add
+			Arguments:
+				Frame *frame: frame in use
+				int process_id, page_number: page mapped to frame too
+				PTE *pte: PTE of page
+			Returns: void
+			Description: adds a mapping right after the first one
+		*/
+		if(free_entry == -1) {
+			Mapping entry = {-1, -1, NULL, -1};
+			entries.push_back(entry);
+			free_entry = entries.size() - 1;
+		}
+		int m = free_entry;
+		free_entry = entries[m].next;
+		entries[m].process_id = process_id;
+		entries[m].page_number = page_number;
+		entries[m].pte = pte;
+		entries[m].next = frame->next_mapping;
+		frame->next_mapping = m;
+		frame->refcount++;
+	}
+
+	void remove(Frame *frame, int process_id, int page_number) {
+		/*
+			Function Name: remove
+			Arguments:
+				Frame *frame: frame mapped by page
+				int process_id, page_number: page whose mapping is removed
+			Returns: void
+			Description: if the first mapping is removed the next one takes its place and 			inherits the referenced and modified bits of the frame. A frame left without 			mappings is free.
+		*/
+		frame->refcount--;
+		if(frame->process_id == process_id && frame->page_number == page_number) {
+			int m = frame->next_mapping;
+			if(m == -1) {
+				frame->process_id = -1;
+				frame->page_number = -1;
+				frame->pte = NULL;
+				frame->cow = false;
+				return;
+			}
+			entries[m].pte->referenced |= frame->pte->referenced;
+			entries[m].pte->modified |= frame->pte->modified;
+			frame->process_id = entries[m].process_id;
+			frame->page_number = entries[m].page_number;
+			frame->pte = entries[m].pte;
+			frame->next_mapping = entries[m].next;
+			release(m);
+			return;
+		}
+		int *link = &frame->next_mapping;
+		while(*link != -1) {
+			int m = *link;
+			if(entries[m].process_id == process_id && entries[m].page_number == page_number) {
+				*link = entries[m].next;
+				release(m);
+				return;
+			}
+			link = &entries[m].next;
+		}
+	}
+
+	void clear(Frame *frame) {
+		/*
+			Function Name: clear
+			Arguments:
+				Frame *frame: frame whose page was evicted from all mappings
+			Returns: void
+			Description: releases the entries of all mappings but the first, the frame 			gets its new page as first mapping
+		*/
+		for(int m = frame->next_mapping; m != -1;) {
+			int next = entries[m].next;
+			release(m);
+			m = next;
+		}
+		frame->next_mapping = -1;
+	}
+
+	void release(int m) {
+		entries[m].process_id = -1;
+		entries[m].pte = NULL;
+		entries[m].next = free_entry;
+		free_entry = m;
+	}
+
+	void state(Snapshot &snapshot, Process **processes) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+				Process **processes: processes of simulation, PTEs of entries are looked up 				in their page tables on load
+			Returns: void
+		*/
+		snapshot.field(entries);
+		snapshot.field(free_entry);
+		if(!snapshot.loading || snapshot.failed) return;
+		for(int m = 0; m < (int)entries.size(); m++) {
+			Mapping &entry = entries[m];
+			entry.pte = (entry.process_id == -1) ? NULL : processes[entry.process_id]->page_table.lookup(entry.page_number);
+		}
+	}
+};
+
+#endif
+
+#ifndef FENWICK_TREE_H
+#define FENWICK_TREE_H
+
+class FenwickTree {
+	/*
+		Class Name: FenwickTree
+		Description: defines a binary indexed tree of counts over positions 0..size-1. 		Supports point updates and prefix sums in O(log size). Nodes are tagged with the 		epoch they were written in, so clearing the tree is O(1).
+	*/
+private:
+	std::vector<int> tree; //node values, 1 based
+	std::vector<unsigned int> version; //epoch in which node was last written
+	unsigned int epoch; //current epoch, nodes of older epochs read as 0
+	int total_count; //sum of all counts
+	unsigned int total_version; //epoch in which total_count was last written
+	int n; //number of positions
+
+public:
+	FenwickTree() {
+		n = 0;
+		epoch = 1;
+		total_count = 0;
+		total_version = epoch;
+	}
+
+	void resize(int size) {
+		/*
+			Function Name: resize
+			Arguments:
+				int size: number of positions
+			Returns: void
+			Description: resets the tree to size positions, all 0
+		*/
+		n = size;
+		tree.assign(n + 1, 0);
+		version.assign(n + 1, epoch);
+		total_count = 0;
+		total_version = epoch;
+	}
+
+	int size() {
+		return n;
+	}
+
+	void clear() {
+		/*
+			Function Name: clear
+			Returns: void
+			Description: sets all counts to 0 by starting a new epoch
+		*/
+		epoch++;
+	}
+
+	int node(int i) {
+		/*
+			Function Name: node
+			Arguments:
+				int i: node index, 1 based
+			Returns:
+				int: value of node, used to descend the tree
+		*/
+		return (version[i] == epoch) ? tree[i] : 0;
+	}
+
+	int top_step() {
+		/*
+			Function Name: top_step
+			Returns:
+				int: largest power of 2 not above size, first step of a descent
+		*/
+		int step = 1;
+		while(step*2 <= n) step *= 2;
+		return (n == 0) ? 0 : step;
+	}
+
+	int total() {
+		/*
+			Function Name: total
+			Returns:
+				int: sum of all counts
+		*/
+		return (total_version == epoch) ? total_count : 0;
+	}
+
+	void add(int pos, int delta) {
+		/*
+			Function Name: add
+			Arguments:
+				int pos: position, 0 based
+				int delta: value to be added to count of pos
+			Returns: void
+		*/
+		for(int i = pos + 1; i <= n; i += i & (-i)) {
+			if(version[i] != epoch) {
+				version[i] = epoch;
+				tree[i] = 0;
+			}
+			tree[i] += delta;
+		}
+		if(total_version != epoch) {
+			total_version = epoch;
+			total_count = 0;
+		}
+		total_count += delta;
+	}
+
+	int prefix_sum(int pos) {
+		/*
+			Function Name: prefix_sum
+			Arguments:
+				int pos: position, 0 based
+			Returns:
+				int: sum of counts of positions 0..pos-1
+		*/
+		int sum = 0;
+		for(int i = pos; i > 0; i -= i & (-i)) {
+			sum += node(i);
+		}
+		return sum;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(tree);
+		snapshot.field(version);
+		snapshot.field(epoch);
+		snapshot.field(total_count);
+		snapshot.field(total_version);
+	}
+};
+
+#endif
+
+#ifndef LINKED_LISTS_H
+#define LINKED_LISTS_H
+
+class LinkedLists {
+	/*
+		Class Name: LinkedLists
+		Description: defines a set of doubly linked lists over nodes 0..num_nodes-1, every node 		is in at most one list. Links are kept in arrays indexed by node, so nodes are never 		allocated and every operation is O(1). List l has sentinel node num_nodes+l.
+	*/
+private:
+	std::vector<int> next, prev; //links of nodes and sentinels
+	std::vector<int> owner; //list of every node, -1 if in none
+	std::vector<int> sizes; //number of nodes in every list
+	int num_nodes; //number of nodes, sentinels excluded
+
+	void link(int node, int before, int after) {
+		/*
+			Function Name: link
+			Arguments:
+				int node: node to be linked, in no list
+				int before, after: adjacent nodes or sentinels node goes between
+			Returns: void
+		*/
+		int l = (before >= num_nodes) ? before - num_nodes : owner[before];
+		next[before] = node;
+		prev[after] = node;
+		next[node] = after;
+		prev[node] = before;
+		owner[node] = l;
+		sizes[l]++;
+	}
+
+public:
+	LinkedLists(int num_nodes, int num_lists) : next(num_nodes + num_lists), prev(num_nodes + num_lists), owner(num_nodes, -1), sizes(num_lists, 0) {
+		this->num_nodes = num_nodes;
+		for(int l = 0; l < num_lists; l++) {
+			next[num_nodes + l] = prev[num_nodes + l] = num_nodes + l;
+		}
+	}
+
+	int list_of(int node) {
+		return owner[node];
+	}
+
+	int size(int l) {
+		return sizes[l];
+	}
+
+	int front(int l) {
+		/*
+			Function Name: front
+			Arguments:
+				int l: list
+			Returns:
+				int: first node of list, -1 if it is empty
+		*/
+		return (sizes[l] == 0) ? -1 : next[num_nodes + l];
+	}
+
+	int back(int l) {
+		/*
+			Function Name: back
+			Arguments:
+				int l: list
+			Returns:
+				int: last node of list, -1 if it is empty
+		*/
+		return (sizes[l] == 0) ? -1 : prev[num_nodes + l];
+	}
+
+	int next_of(int node) {
+		/*
+			Function Name: next_of
+			Arguments:
+				int node: node in a list
+			Returns:
+				int: node following it in its list, -1 if it is the last one
+		*/
+		return (next[node] >= num_nodes) ? -1 : next[node];
+	}
+
+	int prev_of(int node) {
+		/*
+			Function Name: prev_of
+			Arguments:
+				int node: node in a list
+			Returns:
+				int: node preceding it in its list, -1 if it is the first one
+		*/
+		return (prev[node] >= num_nodes) ? -1 : prev[node];
+	}
+
+	void push_front(int l, int node) {
+		link(node, num_nodes + l, next[num_nodes + l]);
+	}
+
+	void push_back(int l, int node) {
+		link(node, prev[num_nodes + l], num_nodes + l);
+	}
+
+	void insert_before(int pos, int node) {
+		link(node, prev[pos], pos);
+	}
+
+	void insert_after(int pos, int node) {
+		link(node, pos, next[pos]);
+	}
+
+	void remove(int node) {
+		/*
+			Function Name: remove
+			Arguments:
+				int node: node to be taken out of its list
+			Returns: void
+		*/
+		next[prev[node]] = next[node];
+		prev[next[node]] = prev[node];
+		sizes[owner[node]]--;
+		owner[node] = -1;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(next);
+		snapshot.field(prev);
+		snapshot.field(owner);
+		snapshot.field(sizes);
+	}
 };
 
+#endif
+
+#ifndef BIT_TREE_H
+#define BIT_TREE_H
+
+class BitTree {
+	/*
+		Class Name: BitTree
+		Description: defines a set of positions 0..size-1 as a bitmap with a summary bitmap 		on top of it, one bit per word of the level below, up to a single word. Insert, 		erase and lowest element are O(log64 size) and nothing is allocated after resize().
+	*/
+private:
+	std::vector<std::vector<uint64_t> > levels; //levels[0] holds a bit per position, the last one a single word
+
+public:
+	BitTree() {
+		resize(0);
+	}
+
+	void resize(int size) {
+		/*
+			Function Name: resize
+			Arguments:
+				int size: number of positions
+			Returns: void
+			Description: resets the set to size positions, all absent
+		*/
+		levels.clear();
+		int words = size;
+		do {
+			words = (words > 64) ? (words + 63)/64 : 1;
+			levels.push_back(std::vector<uint64_t>(words, 0));
+		} while(words > 1);
+	}
+
+	bool empty() {
+		return levels.back()[0] == 0;
+	}
+
+	bool contains(int pos) {
+		return (levels[0][pos >> 6] >> (pos & 63)) & 1;
+	}
+
+	void insert(int pos) {
+		/*
+			Function Name: insert
+			Arguments:
+				int pos: position to be added
+			Returns: void
+			Description: sets the bit of pos and the summary bits of a word that was empty
+		*/
+		for(int l = 0; l < (int)levels.size(); l++) {
+			uint64_t &word = levels[l][pos >> 6];
+			bool was_empty = (word == 0);
+			word |= 1ULL << (pos & 63);
+			if(!was_empty) return;
+			pos >>= 6;
+		}
+	}
+
+	void erase(int pos) {
+		/*
+			Function Name: erase
+			Arguments:
+				int pos: position to be removed
+			Returns: void
+			Description: clears the bit of pos and the summary bits of a word left empty
+		*/
+		for(int l = 0; l < (int)levels.size(); l++) {
+			uint64_t &word = levels[l][pos >> 6];
+			word &= ~(1ULL << (pos & 63));
+			if(word != 0) return;
+			pos >>= 6;
+		}
+	}
 
-#endif
\ No newline at end of file
+	int lowest() {
+		/*
+			Function Name: lowest
+			Returns:
+				int: least position in the set, -1 if it is empty
+		*/
+		if(empty()) return -1;
+		int pos = 0;
+		for(int l = levels.size() - 1; l >= 0; l--) {
+			pos = (pos << 6) + __builtin_ctzll(levels[l][pos]);
+		}
+		return pos;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		for(int l = 0; l < (int)levels.size(); l++) {
+			snapshot.field(levels[l]);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,298 @@
+/*
+	Module Name: hugepage.h
+	Description: Defines FrameAllocator, the allocator of free frames, and HugePages, the 		reservations of huge pages. Frames are grouped into aligned chunks of the huge page 		size. A fault in an aligned region of a VMA reserves a whole free chunk for it and 		every page of the region goes to its own offset in the chunk, so a region whose pages 		are all in memory is physically contiguous and is promoted to a huge page.
+*/
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "datastructures.h"
+
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+class FrameAllocator {
+	/*
+		Class Name: FrameAllocator
+		Description: hands out free frames one at a time or as whole aligned chunks. Single 		frames come from chunks that are in use already, so whole chunks are kept free for 		huge pages as long as possible. Frames beyond the last whole chunk are only handed 		out one at a time. With chunks of one frame, frames handed back are reused first, 		most recent first, and the others are handed out in frame number order.
+	*/
+private:
+	int chunk_size; //frames per chunk, a power of 2
+	int num_chunks; //number of whole chunks
+	int next_chunk; //chunks below it were handed out before
+	int num_free; //free frames, whole chunks included
+	std::vector<int> free_chunks; //whole chunks handed back, most recent last
+	std::vector<int> chunk_free; //free frames of every chunk in use, unused with chunks of one frame
+	LinkedLists loose; //list 0: free frames of chunks in use and beyond the last chunk, most recent first
+
+	int take_chunk() {
+		/*
+			Function Name: take_chunk
+			Returns:
+				int: whole free chunk, -1 if there is none
+		*/
+		if(!free_chunks.empty()) {
+			int c = free_chunks.back();
+			free_chunks.pop_back();
+			return c;
+		}
+		if(next_chunk < num_chunks) return next_chunk++;
+		return -1;
+	}
+
+public:
+	FrameAllocator(int frame_limit, int chunk_size) : loose(chunk_size > 1 ? frame_limit : 0, 1) {
+		/*
+			Function Name: constructor
+			Arguments:
+				int frame_limit: number of frames, all of them free
+				int chunk_size: frames per chunk, a power of 2
+		*/
+		this->chunk_size = chunk_size;
+		num_chunks = frame_limit/chunk_size;
+		next_chunk = 0;
+		num_free = frame_limit;
+		if(chunk_size > 1) chunk_free.assign(num_chunks, 0);
+		for(int f = num_chunks*chunk_size; f < frame_limit; f++) {
+			loose.push_back(0, f);
+		}
+	}
+
+	int chunks() {
+		return num_chunks;
+	}
+
+	int free_count() {
+		return num_free;
+	}
+
+	int alloc_frame() {
+		/*
+			Function Name: alloc_frame
+			Returns:
+				int: free frame, -1 if memory is exhausted
+			Description: a chunk is split only if no chunk in use has a free frame, its 			other frames are handed out next in frame number order
+		*/
+		if(loose.size(0) > 0) {
+			num_free--;
+			int f = loose.front(0);
+			loose.remove(f);
+			if(f < num_chunks*chunk_size) chunk_free[f/chunk_size]--;
+			return f;
+		}
+		int c = take_chunk();
+		if(c == -1) return -1;
+		num_free--;
+		for(int f = (c + 1)*chunk_size - 1; f > c*chunk_size; f--) {
+			loose.push_front(0, f);
+		}
+		if(chunk_size > 1) chunk_free[c] = chunk_size - 1;
+		return c*chunk_size;
+	}
+
+	int alloc_chunk() {
+		/*
+			Function Name: alloc_chunk
+			Returns:
+				int: whole free chunk, all its frames are in use now, -1 if there is none
+		*/
+		int c = take_chunk();
+		if(c == -1) return -1;
+		num_free -= chunk_size;
+		if(chunk_size > 1) chunk_free[c] = 0;
+		return c;
+	}
+
+	void free_frame(int f) {
+		/*
+			Function Name: free_frame
+			Arguments:
+				int f: frame no page is mapped to any more
+			Returns: void
+			Description: a chunk whose frames are all free again is whole again
+		*/
+		num_free++;
+		if(chunk_size == 1) {
+			free_chunks.push_back(f);
+			return;
+		}
+		if(f >= num_chunks*chunk_size) {
+			loose.push_front(0, f);
+			return;
+		}
+		int c = f/chunk_size;
+		if(++chunk_free[c] < chunk_size) {
+			loose.push_front(0, f);
+			return;
+		}
+		for(int g = c*chunk_size; g < (c + 1)*chunk_size; g++) {
+			if(g != f) loose.remove(g);
+		}
+		free_chunks.push_back(c);
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(next_chunk);
+		snapshot.field(num_free);
+		snapshot.field(free_chunks);
+		snapshot.field(chunk_free);
+		loose.state(snapshot);
+	}
+};
+
+#endif
+
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#define MAX_HUGE_PAGE_BITS PT_LEVEL_BITS //a huge page is at most one leaf of the page table, so its PTEs are contiguous
+
+struct HugeRegion {
+	/*
+		Struct Name: HugeRegion
+		Description: defines the reservation of a chunk of frames for an aligned region of 		pages
+	*/
+	int process_id; //process of region, -1 if chunk is not reserved
+	int first_page; //first page of region, a multiple of the huge page size
+	int populated; //pages of region in memory, each one at its own offset in chunk
+	bool promoted; //whether all pages are in memory and region is mapped as a huge page
+};
+
+class HugePages {
+	/*
+		Class Name: HugePages
+		Description: defines the reservations of huge pages, one per chunk of frames. A 		reservation that is not fully populated holds free frames, it is broken when memory 		runs out, least recently populated first. A promoted region is demoted back to base 		pages when one of its pages is unmapped.
+	*/
+private:
+	std::unordered_map<uint64_t, int> reserved; //chunk reserved for region of every process
+
+	static uint64_t key(int process_id, int first_page) {
+		return ((uint64_t)process_id << 32) | (uint32_t)first_page;
+	}
+
+public:
+	int size; //pages per huge page, a power of 2
+	int bits; //log2 of size
+	std::vector<HugeRegion> regions; //reservation of every chunk
+	LinkedLists partial; //list 0: chunks reserved and not fully populated, most recently populated first
+	int reserved_free; //frames of reservations no page is mapped to yet
+
+	HugePages(int bits, int num_chunks) : regions(num_chunks), partial(num_chunks, 1) {
+		/*
+			Function Name: constructor
+			Arguments:
+				int bits: log2 of pages per huge page
+				int num_chunks: number of chunks of frames
+		*/
+		this->bits = bits;
+		size = 1 << bits;
+		reserved_free = 0;
+		for(int c = 0; c < num_chunks; c++) {
+			regions[c].process_id = -1;
+			regions[c].first_page = -1;
+			regions[c].populated = 0;
+			regions[c].promoted = false;
+		}
+	}
+
+	int find(int process_id, int first_page) {
+		/*
+			Function Name: find
+			Arguments:
+				int process_id, int first_page: region
+			Returns:
+				int: chunk reserved for region, -1 if there is none
+		*/
+		std::unordered_map<uint64_t, int>::iterator it = reserved.find(key(process_id, first_page));
+		return (it == reserved.end()) ? -1 : it->second;
+	}
+
+	HugeRegion *region_of(int frame_number) {
+		/*
+			Function Name: region_of
+			Arguments:
+				int frame_number: frame in use
+			Returns:
+				HugeRegion*: reservation frame belongs to, NULL if there is none
+		*/
+		int c = frame_number >> bits;
+		if(c >= (int)regions.size() || regions[c].process_id == -1) return NULL;
+		return &regions[c];
+	}
+
+	void reserve(int c, int process_id, int first_page) {
+		/*
+			Function Name: reserve
+			Arguments:
+				int c: whole free chunk
+				int process_id, int first_page: region the chunk is reserved for
+			Returns: void
+		*/
+		regions[c].process_id = process_id;
+		regions[c].first_page = first_page;
+		regions[c].populated = 0;
+		regions[c].promoted = false;
+		reserved[key(process_id, first_page)] = c;
+		reserved_free += size;
+	}
+
+	bool populate(int c) {
+		/*
+			Function Name: populate
+			Arguments:
+				int c: reserved chunk a page of its region was just mapped to
+			Returns: bool - whether region is fully populated now
+		*/
+		if(partial.list_of(c) != -1) partial.remove(c);
+		reserved_free--;
+		if(++regions[c].populated < size) {
+			partial.push_front(0, c);
+			return false;
+		}
+		return true;
+	}
+
+	void release(int c) {
+		/*
+			Function Name: release
+			Arguments:
+				int c: reserved chunk
+			Returns: void
+			Description: forgets the reservation, the pages in memory stay where they are as 			base pages
+		*/
+		if(partial.list_of(c) != -1) partial.remove(c);
+		reserved_free -= size - regions[c].populated;
+		reserved.erase(key(regions[c].process_id, regions[c].first_page));
+		regions[c].process_id = -1;
+		regions[c].first_page = -1;
+		regions[c].populated = 0;
+		regions[c].promoted = false;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+			Description: the map from regions to chunks and the count of their free frames 			are rebuilt from the reservations
+		*/
+		snapshot.field(regions);
+		partial.state(snapshot);
+		if(!snapshot.loading || snapshot.failed) return;
+		reserved.clear();
+		reserved_free = 0;
+		for(int c = 0; c < (int)regions.size(); c++) {
+			if(regions[c].process_id == -1) continue;
+			reserved[key(regions[c].process_id, regions[c].first_page)] = c;
+			reserved_free += size - regions[c].populated;
+		}
+	}
+};
+
+#endif
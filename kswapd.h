@@ -0,0 +1,167 @@
+/*
+	Module Name: kswapd.h
+	Description: Defines KswapdConfig, the options of simulated time and of the background 		reclaimer, Disk, the model of the device pages are read from and written to, and 		LatencyHistogram, the distribution of fault latencies. Simulated time is counted in 		the units of TOTALCOST: the simulated CPU spends the cost of every event as it does 		today, and a fault that reads or writes a page also waits for the disk.
+*/
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "snapshot.h"
+
+#ifndef KSWAPD_H
+#define KSWAPD_H
+
+#define IO_LATENCY 20000 //default time of a disk request besides the transfer of its pages
+#define KSWAPD_BATCH 32 //default victims asked of the pager at once
+#define SWAP_TRANSFER_TIME 3000 //transfer of a page to or from swap, its cost in TOTALCOST
+#define FILE_TRANSFER_TIME 2500 //transfer of a page to or from its file, its cost in TOTALCOST
+
+struct KswapdConfig {
+	/*
+		Struct Name: KswapdConfig
+		Description: defines the options of simulated time and of kswapd
+	*/
+	bool timed; //whether simulated time is kept and fault latencies are recorded
+	unsigned long int io_latency; //time of a disk request besides the transfer of its pages
+	int low; //kswapd wakes when fewer frames are free or being written back, 0 for no kswapd
+	int high; //kswapd reclaims until that many frames are free or being written back
+	int batch; //victims asked of the pager at once
+};
+
+struct Writeback {
+	/*
+		Struct Name: Writeback
+		Description: defines a frame whose page kswapd is writing out, it is free once done
+	*/
+	int frame_number; //frame being written back
+	unsigned long long int done; //time the write completes
+};
+
+class Disk {
+	/*
+		Class Name: Disk
+		Description: defines a disk serving one request at a time in the order they were 		issued. A request takes the latency plus the transfer of its pages.
+	*/
+private:
+	unsigned long int latency; //time of a request besides its transfer
+	unsigned long long int busy_until; //time the last request issued completes
+
+public:
+	std::deque<Writeback> writeback; //frames written back by kswapd, in order of completion
+
+	Disk(unsigned long int latency) {
+		this->latency = latency;
+		busy_until = 0;
+	}
+
+	unsigned long long int request(unsigned long long int now, unsigned long int transfer) {
+		/*
+			Function Name: request
+			Arguments:
+				unsigned long long int now: time the request is issued
+				unsigned long int transfer: time the pages of request take to transfer
+			Returns:
+				unsigned long long int: time the request completes, after the ones issued before
+		*/
+		unsigned long long int start = (busy_until > now) ? busy_until : now;
+		busy_until = start + latency + transfer;
+		return busy_until;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(busy_until);
+		std::vector<Writeback> pending(writeback.begin(), writeback.end());
+		snapshot.field(pending);
+		if(snapshot.loading) writeback.assign(pending.begin(), pending.end());
+	}
+};
+
+#define LATENCY_SUB_BITS 4 //every power of 2 is split into 2^LATENCY_SUB_BITS buckets
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+class LatencyHistogram {
+	/*
+		Class Name: LatencyHistogram
+		Description: counts latencies in buckets of logarithmic width, so percentiles are 		within 1/16 of the exact ones and memory does not grow with the number of faults. 		Latencies below 16 have a bucket of their own.
+	*/
+private:
+	std::vector<unsigned long int> counts; //latencies counted in every bucket
+
+	static int bucket(unsigned long long int value) {
+		if(value < (1u << LATENCY_SUB_BITS)) return (int)value;
+		int e = 63 - __builtin_clzll(value);
+		int sub = (int)(value >> (e - LATENCY_SUB_BITS)) & ((1 << LATENCY_SUB_BITS) - 1);
+		return ((e - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+	}
+
+	static unsigned long long int upper(int b) {
+		/*
+			Function Name: upper
+			Arguments:
+				int b: bucket
+			Returns:
+				unsigned long long int: largest latency counted in bucket
+		*/
+		if(b < (1 << LATENCY_SUB_BITS)) return b;
+		int e = (b >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+		unsigned long long int sub = b & ((1 << LATENCY_SUB_BITS) - 1);
+		unsigned long long int lower = ((1ull << LATENCY_SUB_BITS) + sub) << (e - LATENCY_SUB_BITS);
+		return lower + (1ull << (e - LATENCY_SUB_BITS)) - 1;
+	}
+
+public:
+	unsigned long int count; //latencies counted
+	unsigned long long int sum; //sum of latencies
+	unsigned long long int max; //largest latency
+
+	LatencyHistogram() : counts(LATENCY_BUCKETS, 0) {
+		count = 0;
+		sum = 0;
+		max = 0;
+	}
+
+	void add(unsigned long long int value) {
+		counts[bucket(value)]++;
+		count++;
+		sum += value;
+		if(value > max) max = value;
+	}
+
+	unsigned long long int percentile(int per_mille) {
+		/*
+			Function Name: percentile
+			Arguments:
+				int per_mille: share of latencies, in 1/1000
+			Returns:
+				unsigned long long int: least latency at least that share is not above, 0 if 			none was counted
+		*/
+		unsigned long int rank = (count*(unsigned long long int)per_mille + 999)/1000;
+		if(rank == 0) rank = 1;
+		unsigned long int seen = 0;
+		for(int b = 0; b < LATENCY_BUCKETS; b++) {
+			seen += counts[b];
+			if(seen >= rank) return (upper(b) < max) ? upper(b) : max;
+		}
+		return max;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(counts);
+		snapshot.field(count);
+		snapshot.field(sum);
+		snapshot.field(max);
+	}
+};
+
+#endif
@@ -1,35 +1,85 @@
 /*
 	Module Name: main.cpp
-	Description: Entry point of program. Defines global data structures for containing all 		processes and frame table. Acts as the controller for the program
+	Description: Entry point of program. Parses the options and acts as the controller for 		the program
 */
 #include <stdio.h>
 #include <string.h>
 #include <fstream>
 #include <unistd.h>
-#include "datastructures.h"
+#include <fcntl.h>
+#include <getopt.h>
+#include <vector>
+#include "simulator.h"
 
 
 /*************************** imported from random.cpp ***************************/
-extern void load_random_numbers(char *filename);
+extern RandomTable* load_random_numbers(char *filename);
 
 
-/*************************** imported from readinput.cpp ***************************/
-extern void openInputFile(char *filename);
-extern void initProcess();
+/*************************** imported from stackdistance.cpp ***************************/
+extern void run_stack_distance(InputFile *input, char *kinds, int max_frames);
 
-/*************************** imported from simulate.cpp ***************************/
-extern void simulate();
 
+/*************************** imported from sweep.cpp ***************************/
+extern void run_sweep(InputFile *input, SimulatorConfig config, char *algos, std::vector<int> &frame_counts, int num_threads);
+extern void run_local(InputFile *input, SimulatorConfig config, std::vector<int> &quotas, int num_threads);
 
 
-/**************************** Global Variables ****************************/
-Process **processes; //holds all the processes
-int frame_limit; //memory size
-Frame **frame_table; //holds all the frames
-int curr_frame_index = 0; //used for initial allocation of frames
-int num_processes; //total number of processes using the system
-bool O_flag = false, P_flag = false, F_flag = false, S_flag = false, x_flag = false, f_flag = false; //flags provided in option
-char algo = 'n'; //algorithm to be implemented
+/*************************** imported from batch.cpp ***************************/
+extern int run_batch(char *manifest, int vpage_bits, const char *output_dir, int num_threads);
+
+
+bool parse_tlb_level(char *spec, int *entries, int *ways) {
+	/*
+		Function Name: parse_tlb_level
+		Arguments:
+			char *spec: "<entries>[:<ways>]", ways are 4 if left out
+			int *entries, int *ways: set to geometry of level
+		Returns: bool - false if spec is not a level with a power of 2 sets
+	*/
+	char *colon = strchr(spec, ':');
+	*entries = atoi(spec);
+	*ways = (colon != NULL) ? atoi(colon + 1) : 4;
+	if(*ways > *entries) *ways = *entries;
+	if(*entries < 1 || *ways < 1 || *entries % *ways != 0) return false;
+	int sets = *entries / *ways;
+	return (sets & (sets - 1)) == 0;
+}
+
+
+bool parse_tlb(char *spec, TLBConfig *config) {
+	/*
+		Function Name: parse_tlb
+		Arguments:
+			char *spec: "<L1>[,<L2>]" as taken by parse_tlb_level()
+			TLBConfig *config: set to geometry of TLB, flush_on_switch is left as it is
+		Returns: bool - false if spec is invalid
+	*/
+	char *comma = strchr(spec, ',');
+	if(comma != NULL) *comma = '\0';
+	if(!parse_tlb_level(spec, &config->l1_entries, &config->l1_ways)) return false;
+	config->l2_entries = config->l2_ways = 0;
+	if(comma != NULL && !parse_tlb_level(comma + 1, &config->l2_entries, &config->l2_ways)) return false;
+	return true;
+}
+
+
+bool parse_kswapd(char *spec, KswapdConfig *config) {
+	/*
+		Function Name: parse_kswapd
+		Arguments:
+			char *spec: "<low>,<high>[,<batch>]", batch is KSWAPD_BATCH if left out
+			KswapdConfig *config: set to watermarks and batch, time options are left as they are
+		Returns: bool - false if spec is invalid
+	*/
+	char *high = strchr(spec, ',');
+	if(high == NULL) return false;
+	char *batch = strchr(high + 1, ',');
+	config->low = atoi(spec);
+	config->high = atoi(high + 1);
+	config->batch = (batch != NULL) ? atoi(batch + 1) : KSWAPD_BATCH;
+	return config->low >= 1 && config->high >= config->low && config->batch >= 1;
+}
 
 
 
@@ -44,18 +94,135 @@ int main(int argc, char *argv[]) {
 	*/
 
 	int opt;
-	int num = -1; 
 	char *option;
+	bool O_flag = false, P_flag = false, F_flag = false, S_flag = false, x_flag = false, f_flag = false; //flags provided in option
+	char algos[16] = "n"; //algorithms to be implemented, more than one for a sweep
+	std::vector<int> frame_counts; //memory sizes, more than one for a sweep
+	std::vector<int> quotas; //frames of every process in local replacement, empty for global replacement
+	int num_threads = 0; //worker threads of a sweep, 0 for one per hardware thread
+	char *curves = NULL; //miss curves to be computed instead of simulating
+	char *output_file = NULL; //file output is written to instead of stdout
+	char *manifest = NULL; //jobs of a batch
+	int vpage_bits = 6; //width of virtual address space in pages, 64 pages by default
+	char *checkpoint_file = NULL; //snapshot file written while simulating
+	unsigned long int checkpoint_interval = 10000000; //commands between two snapshots
+	char *resume_file = NULL; //snapshot file the simulation continues from
+	TLBConfig tlb; //geometry of TLB, none by default
+	memset(&tlb, 0, sizeof(tlb));
+	int huge_pages = 0; //pages per huge page, no huge pages by default
+	KswapdConfig kswapd; //simulated time and kswapd, none by default
+	memset(&kswapd, 0, sizeof(kswapd));
 
-	while((opt = getopt(argc, argv, "a:f:o:")) != -1) {
+	//options without a letter of their own
+	static struct option long_options[] = {
+		{"checkpoint", required_argument, NULL, 'C'},
+		{"checkpoint-every", required_argument, NULL, 'E'},
+		{"resume", required_argument, NULL, 'R'},
+		{"perf-counters", no_argument, NULL, 'H'},
+		{"tlb", required_argument, NULL, 'T'},
+		{"tlb-flush", no_argument, NULL, 'U'},
+		{"huge", required_argument, NULL, 'L'},
+		{"kswapd", required_argument, NULL, 'K'},
+		{"io-latency", required_argument, NULL, 'I'},
+		{NULL, 0, NULL, 0}
+	};
+
+	while((opt = getopt_long(argc, argv, "a:f:o:v:j:d:w:b:q:", long_options, NULL)) != -1) {
 		switch(opt) {
-		//get the algorithm to be implemented
+		//get the algorithm to be implemented, several letters run a sweep
 		case 'a':
-			if(optarg != NULL) algo = optarg[0];
+			if(optarg != NULL) {
+				strncpy(algos, optarg, sizeof(algos) - 1);
+				algos[sizeof(algos) - 1] = '\0';
+			}
 			break;
-		//get the physical memory size
+		//get the physical memory size, a comma separated list runs a sweep
 		case 'f':
-			if(optarg != NULL) num = atoi(optarg);
+			if(optarg != NULL) {
+				frame_counts.clear();
+				for(char *num = strtok(optarg, ","); num != NULL; num = strtok(NULL, ",")) {
+					frame_counts.push_back(atoi(num));
+				}
+			}
+			break;
+		//get the frames of every process, a comma separated list selects local replacement
+		case 'q':
+			if(optarg != NULL) {
+				quotas.clear();
+				for(char *num = strtok(optarg, ","); num != NULL; num = strtok(NULL, ",")) {
+					quotas.push_back(atoi(num));
+				}
+			}
+			break;
+		//get the number of worker threads of a sweep or local replacement
+		case 'j':
+			if(optarg != NULL) num_threads = atoi(optarg);
+			break;
+		//get the miss curves to be computed, 'l' for LRU and 'o' for OPT
+		case 'd':
+			curves = optarg;
+			break;
+		//get the file output is written to, or the directory of a batch
+		case 'w':
+			output_file = optarg;
+			break;
+		//get the manifest of a batch
+		case 'b':
+			manifest = optarg;
+			break;
+		//get the snapshot file to be written and how often
+		case 'C':
+			checkpoint_file = optarg;
+			break;
+		case 'E':
+			if(optarg != NULL) checkpoint_interval = strtoul(optarg, NULL, 10);
+			break;
+		//get the snapshot file to continue from
+		case 'R':
+			resume_file = optarg;
+			break;
+		//read hardware counters around every profiled block
+		case 'H':
+			if(!PROFILE_ENABLE_EVENTS()) {
+				fprintf(stderr, "--perf-counters needs the profiling build, make mmu_profile\n");
+				return 1;
+			}
+			break;
+		//get the geometry of TLB and whether context switches flush it
+		case 'T':
+			if(!parse_tlb(optarg, &tlb)) {
+				fprintf(stderr, "--tlb takes <entries>[:<ways>][,<entries>[:<ways>]] with a power of 2 sets\n");
+				return 1;
+			}
+			break;
+		case 'U':
+			tlb.flush_on_switch = true;
+			break;
+		//get the size of huge pages in pages
+		case 'L':
+			huge_pages = atoi(optarg);
+			if(huge_pages < 2 || huge_pages > (1 << MAX_HUGE_PAGE_BITS) || (huge_pages & (huge_pages - 1)) != 0) {
+				fprintf(stderr, "--huge takes a power of 2 pages between 2 and %d\n", 1 << MAX_HUGE_PAGE_BITS);
+				return 1;
+			}
+			break;
+		//get the watermarks of kswapd, it needs simulated time
+		case 'K':
+			if(!parse_kswapd(optarg, &kswapd)) {
+				fprintf(stderr, "--kswapd takes <low>,<high>[,<batch>] with 1 <= low <= high and batch >= 1\n");
+				return 1;
+			}
+			if(!kswapd.timed) kswapd.io_latency = IO_LATENCY;
+			kswapd.timed = true;
+			break;
+		//get the latency of disk requests, fault latencies are recorded
+		case 'I':
+			kswapd.io_latency = strtoul(optarg, NULL, 10);
+			kswapd.timed = true;
+			break;
+		//get the width of virtual address space in pages
+		case 'v':
+			if(optarg != NULL) vpage_bits = atoi(optarg);
 			break;
 		//get all the other optional arguments
 		case 'o':
@@ -91,23 +258,144 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
-	load_random_numbers(argv[optind+1]); //load the random numbers from the rfile
-	
-	//initialize the global file variable defined in readinput.cpp
-	openInputFile(argv[optind]);
-	//initialize all the processes along with its page table
-	initProcess();
-
-	//initialize the frame table
-	frame_limit = num;
-	frame_table = (Frame**)malloc(sizeof(Frame*)*frame_limit);
-	for(int i = 0; i < frame_limit; i++) {
-		frame_table[i] = (Frame*)malloc(sizeof(Frame));
-		frame_table[i]->process_id = -1;
-		frame_table[i]->page_number = -1;
-		frame_table[i]->frame_number = i;
+	if(vpage_bits < 1 || vpage_bits > MAX_VPAGE_BITS) {
+		fprintf(stderr, "virtual address width must be between 1 and %d bits\n", MAX_VPAGE_BITS);
+		return 1;
+	}
+
+	//jobs of a batch bring their own input files and options
+	if(manifest != NULL) {
+		return run_batch(manifest, vpage_bits, (output_file != NULL) ? output_file : ".", num_threads);
+	}
+
+	//physical memory must be addressable by frame index of PTE
+	if(frame_counts.empty()) frame_counts.push_back(quotas.empty() ? -1 : quotas[0]);
+	for(int i = 0; i < (int)frame_counts.size(); i++) {
+		if(frame_counts[i] < 1 || frame_counts[i] > MAX_FRAMES) {
+			fprintf(stderr, "number of frames must be between 1 and %d\n", MAX_FRAMES);
+			return 1;
+		}
+	}
+	for(int i = 0; i < (int)quotas.size(); i++) {
+		if(quotas[i] < 1 || quotas[i] > MAX_FRAMES) {
+			fprintf(stderr, "number of frames must be between 1 and %d\n", MAX_FRAMES);
+			return 1;
+		}
+	}
+
+	//kswapd keeps fewer frames free than there are
+	for(int i = 0; i < (int)frame_counts.size(); i++) {
+		if(kswapd.high >= frame_counts[i]) {
+			fprintf(stderr, "high watermark of --kswapd must be below the number of frames\n");
+			return 1;
+		}
+	}
+
+	//snapshots are only taken of a single simulation
+	bool single = (manifest == NULL && quotas.empty() && curves == NULL && strlen(algos) == 1 && frame_counts.size() == 1);
+	if((checkpoint_file != NULL || resume_file != NULL) && !single) {
+		fprintf(stderr, "--checkpoint and --resume only work with a single simulation\n");
+		return 1;
+	}
+	if(checkpoint_interval == 0) checkpoint_interval = 1;
+
+	//partitions of local replacement see only part of the references, OPT needs all of them
+	if(!quotas.empty() && (strlen(algos) > 1 || strchr(algos, 'o') != NULL || curves != NULL)) {
+		fprintf(stderr, "local replacement runs a single algorithm other than o\n");
+		return 1;
+	}
+
+	//partitions of local replacement share no disk, their time can not be merged
+	if(!quotas.empty() && kswapd.timed) {
+		fprintf(stderr, "--kswapd and --io-latency do not work with local replacement\n");
+		return 1;
 	}
+
+	RandomTable *random_table = load_random_numbers(argv[optind+1]); //load the random numbers from the rfile
 	
+	//open the input file
+	InputFile input(vpage_bits);
+	input.openInputFile(argv[optind]);
+	//initialize all the processes along with their VMAs
+	input.initProcess();
+
+	//miss curves for every memory size up to the largest one given
+	if(curves != NULL) {
+		int max_frames = 0;
+		for(int i = 0; i < (int)frame_counts.size(); i++) {
+			if(frame_counts[i] > max_frames) max_frames = frame_counts[i];
+		}
+		run_stack_distance(&input, curves, max_frames);
+		return 0;
+	}
+
+	SimulatorConfig config;
+	config.algo = algos[0];
+	config.frame_limit = frame_counts[0];
+	config.vpage_bits = vpage_bits;
+	config.O_flag = O_flag;
+	config.P_flag = P_flag;
+	config.F_flag = F_flag;
+	config.S_flag = S_flag;
+	config.x_flag = x_flag;
+	config.f_flag = f_flag;
+	config.random_table = random_table;
+	config.partition = -1;
+	config.tlb = tlb;
+	config.huge_pages = huge_pages;
+	config.kswapd = kswapd;
+	config.output_fd = STDOUT_FILENO;
+	if(output_file != NULL) {
+		//output of a resumed simulation continues the output of the one that was stopped, which
+		//has to exist
+		config.output_fd = open(output_file, O_WRONLY | (resume_file != NULL ? 0 : O_CREAT | O_TRUNC), 0644);
+		if(config.output_fd < 0) {
+			perror(output_file);
+			return 1;
+		}
+	}
+
+	//every process replaces pages in its own frames only
+	if(!quotas.empty()) {
+		run_local(&input, config, quotas, num_threads);
+		return 0;
+	}
+
+	//several algorithms or memory sizes share one pass over input file
+	if(strlen(algos) > 1 || frame_counts.size() > 1) {
+		run_sweep(&input, config, algos, frame_counts, num_threads);
+		return 0;
+	}
+
 	//run the simulation
-	simulate();
-}
\ No newline at end of file
+	Simulator simulator(config, &input);
+	simulator.checkpoint_path = checkpoint_file;
+	simulator.checkpoint_interval = checkpoint_interval;
+	if(resume_file != NULL) {
+		if(!simulator.load_checkpoint(&input, resume_file)) return 1;
+
+		//drop output written after the snapshot was taken, a file that does not hold all the
+		//output before the snapshot would end up incomplete
+		if(output_file != NULL) {
+			off_t size = lseek(config.output_fd, 0, SEEK_END);
+			if(size < (off_t)simulator.output_offset) {
+				fprintf(stderr, "%s holds %lld bytes of output, the snapshot was taken after %llu\n", output_file, (long long int)size, simulator.output_offset);
+				return 1;
+			}
+			if(ftruncate(config.output_fd, simulator.output_offset) != 0) {
+				perror(output_file);
+				return 1;
+			}
+			lseek(config.output_fd, simulator.output_offset, SEEK_SET);
+		}
+	}
+
+	//decoding, simulating and formatting O output run as a pipeline on up to three threads if
+	//-j asks for them, snapshots are only taken by the sequential loop
+	if(num_threads >= 2 && checkpoint_file == NULL) {
+		simulator.simulate_pipelined(&input, num_threads);
+	} else {
+		simulator.simulate(&input);
+	}
+	return 0;
+}
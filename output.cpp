@@ -0,0 +1,157 @@
+/*
+	Module Name: output.cpp
+	Description: Implements the writer thread and buffer handoff of OutputBuffer
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include "output.h"
+#include "profile.h"
+
+
+OutputBuffer::OutputBuffer(int fd) {
+	/*
+		Function Name: constructor
+		Arguments:
+			int fd: file descriptor output is written to, it is not closed
+		Description: allocates the buffers, the writer thread is started on demand
+	*/
+	this->fd = fd;
+	buffers[0] = (char*)malloc(OUTPUT_BUFFER_SIZE);
+	buffers[1] = (char*)malloc(OUTPUT_BUFFER_SIZE);
+	curr = 0;
+	pos = buffers[0];
+	end = buffers[0] + OUTPUT_BUFFER_SIZE;
+	pending = NULL;
+	pending_size = 0;
+	stopping = false;
+	bytes_written = 0;
+}
+
+
+OutputBuffer::~OutputBuffer() {
+	flush();
+	if(writer.joinable()) {
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			stopping = true;
+			submitted.notify_all();
+		}
+		writer.join();
+	}
+	free(buffers[0]);
+	free(buffers[1]);
+}
+
+
+void OutputBuffer::write_all(const char *data, size_t size) {
+	/*
+		Function Name: write_all
+		Arguments:
+			const char *data: bytes to be written
+			size_t size: number of bytes
+		Returns: void
+		Description: writes all bytes to output file, retrying short writes, and exits on failure
+	*/
+	PROFILE_SCOPE("OutputBuffer::write_all");
+	while(size > 0) {
+		ssize_t n = write(fd, data, size);
+		if(n < 0) {
+			if(errno == EINTR) continue;
+			perror("write");
+			exit(1);
+		}
+		data += n;
+		size -= n;
+		bytes_written += n;
+	}
+}
+
+
+void OutputBuffer::write_loop() {
+	/*
+		Function Name: write_loop
+		Returns: void
+		Description: body of the writer thread, writes every submitted buffer until stopped
+	*/
+	std::unique_lock<std::mutex> guard(lock);
+	while(true) {
+		while(pending == NULL && !stopping) submitted.wait(guard);
+		if(pending == NULL) return;
+
+		//the simulation only touches the other buffer meanwhile
+		const char *data = pending;
+		size_t size = pending_size;
+		guard.unlock();
+		write_all(data, size);
+		guard.lock();
+
+		pending = NULL;
+		written.notify_all();
+	}
+}
+
+
+void OutputBuffer::wait_idle() {
+	/*
+		Function Name: wait_idle
+		Returns: void
+		Description: waits until the writer is done with the buffer handed to it
+	*/
+	std::unique_lock<std::mutex> guard(lock);
+	while(pending != NULL) written.wait(guard);
+}
+
+
+void OutputBuffer::submit(size_t size) {
+	/*
+		Function Name: submit
+		Arguments:
+			size_t size: bytes in buffer being filled
+		Returns: void
+		Description: hands the buffer being filled to the writer and continues with the other one
+	*/
+	if(!writer.joinable()) writer = std::thread(&OutputBuffer::write_loop, this);
+
+	wait_idle();
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		pending = buffers[curr];
+		pending_size = size;
+		submitted.notify_all();
+	}
+	curr = 1 - curr;
+	pos = buffers[curr];
+	end = buffers[curr] + OUTPUT_BUFFER_SIZE;
+}
+
+
+void OutputBuffer::overflow(size_t needed) {
+	/*
+		Function Name: overflow
+		Arguments:
+			size_t needed: bytes about to be appended
+		Returns: void
+		Description: makes room for needed bytes, needed is never larger than a buffer
+	*/
+	if((size_t)(end - pos) >= needed) return;
+	submit(pos - buffers[curr]);
+}
+
+
+void OutputBuffer::flush() {
+	/*
+		Function Name: flush
+		Returns: void
+		Description: writes out everything appended so far and returns once it is written
+	*/
+	size_t size = pos - buffers[curr];
+	if(writer.joinable()) {
+		if(size > 0) submit(size);
+		wait_idle();
+	} else if(size > 0) {
+		write_all(buffers[curr], size);
+		pos = buffers[curr];
+	}
+}
@@ -0,0 +1,110 @@
+/*
+	Module Name: output.h
+	Description: Defines OutputBuffer, the buffered output of a simulation. Text is formatted 		into a large buffer by hand, full buffers are written out by a background writer 		thread while the simulation goes on filling the other one.
+*/
+#include <stddef.h>
+#include <string.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#define OUTPUT_BUFFER_SIZE (1 << 20) //bytes formatted before a buffer is handed to the writer
+
+class OutputBuffer {
+	/*
+		Class Name: OutputBuffer
+		Description: collects the output of one simulation. Two buffers are used, one is 		filled by the simulation and the other one is written by the writer thread. The 		writer thread is only started once a buffer fills up, short outputs are written 		directly by flush().
+	*/
+private:
+	int fd; //file descriptor output is written to
+	char *buffers[2]; //buffer being filled and buffer being written
+	int curr; //index of buffer being filled
+	char *end; //end of buffer being filled
+
+	std::thread writer; //writes full buffers, started on first full buffer
+	std::mutex lock;
+	std::condition_variable submitted; //signalled when a buffer is handed to the writer
+	std::condition_variable written; //signalled when the writer is done with a buffer
+	const char *pending; //buffer handed to the writer, NULL if writer is idle
+	size_t pending_size; //bytes in buffer handed to the writer
+	bool stopping; //whether the writer has to exit once idle
+
+	void write_all(const char *data, size_t size);
+	void write_loop();
+	void submit(size_t size);
+	void wait_idle();
+	void overflow(size_t needed);
+
+public:
+	char *pos; //next free byte of buffer being filled
+	unsigned long long int bytes_written; //bytes written to file, all appended ones once flushed
+
+	OutputBuffer(int fd);
+	~OutputBuffer();
+
+	void flush();
+
+	void put(char c) {
+		/*
+			Function Name: put
+			Arguments:
+				char c: character to be appended
+			Returns: void
+		*/
+		if(pos == end) overflow(1);
+		*pos++ = c;
+	}
+
+	void put(const char *s) {
+		/*
+			Function Name: put
+			Arguments:
+				const char *s: string to be appended
+			Returns: void
+		*/
+		size_t len = strlen(s);
+		if((size_t)(end - pos) < len) overflow(len);
+		memcpy(pos, s, len);
+		pos += len;
+	}
+
+	void put_uint(unsigned long long int n) {
+		/*
+			Function Name: put_uint
+			Arguments:
+				unsigned long long int n: number to be appended in decimal
+			Returns: void
+			Description: formats digits from the last one into a scratch area, same output 			as %lu and %llu
+		*/
+		char digits[20];
+		int i = 20;
+		do {
+			digits[--i] = '0' + n % 10;
+			n /= 10;
+		} while(n != 0);
+		if(end - pos < 20) overflow(20);
+		memcpy(pos, digits + i, 20 - i);
+		pos += 20 - i;
+	}
+
+	void put_int(long long int n) {
+		/*
+			Function Name: put_int
+			Arguments:
+				long long int n: number to be appended in decimal
+			Returns: void
+			Description: same output as %d and %ld
+		*/
+		if(n < 0) {
+			put('-');
+			put_uint(0ULL - (unsigned long long int)n);
+		} else {
+			put_uint(n);
+		}
+	}
+};
+
+#endif
@@ -3,21 +3,11 @@
 	Description: Defines all the pagers implementing different algorithms
 */
 #include "datastructures.h"
+#include "random.h"
+#include <stdint.h>
 #include <vector>
-#include <list>
-
-/*************************** imported from main.cpp ***************************/
-extern Frame **frame_table;
-extern int frame_limit;
-extern Process **processes;
-
-/*************************** imported from random.cpp ***************************/
-extern int myrandom(int size);
-
-
-/*************************** imported from simulate.cpp ***************************/
-extern std::vector<unsigned int> age;
-
+#include <algorithm>
+#include <unordered_map>
 
 
 #ifndef PAGER_H
@@ -26,9 +16,31 @@ extern std::vector<unsigned int> age;
 class Pager {
 	/*
 		Class Name: Pager
-		Description: defines a virtual parent pager class
+		Description: defines a virtual parent pager class. A pager works on the frame table 		of the simulator that created it.
 	*/
+protected:
+	Frame *frame_table; //holds all the frames
+	int frame_limit; //memory size
+	RandomGenerator *random; //random numbers of the simulator
+
+	int myrandom(int size) {
+		return random->myrandom(size);
+	}
+
 public:
+	Pager(Frame *frame_table, int frame_limit, RandomGenerator *random) {
+		/*
+			Function Name: constructor
+			Arguments:
+				Frame *frame_table: frame table of simulator
+				int frame_limit: number of frames in frame table
+				RandomGenerator *random: random numbers of simulator
+			Description: Initializes all the members of class
+		*/
+		this->frame_table = frame_table;
+		this->frame_limit = frame_limit;
+		this->random = random;
+	}
 
 	//virtual function to be implemented by all childrens
 	virtual Frame* determine_victim_frame() {
@@ -40,6 +52,82 @@ public:
 		*/
 		return NULL;
 	};
+
+	virtual void page_fault(int process_id, int page_number) {
+		/*
+			Function Name: page_fault
+			Arguments:
+				int process_id: process of the page that is not in memory
+				int page_number: page that is not in memory
+			Returns: void
+			Description: called by simulator on every page fault, before a frame is looked for. 			Allows pagers that remember evicted pages to recognise them
+		*/
+		(void)process_id;
+		(void)page_number;
+	}
+
+	virtual void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+			Description: called by simulator on every reference to a page in memory, after the 			referenced and modified bits of the page are updated. Allows pagers to keep their 			bookkeeping up to date incrementally
+		*/
+		(void)frame;
+	}
+
+	virtual void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed, e.g. as its process exited
+			Returns: void
+			Description: called by simulator when a frame is left without a page instead of 			getting a new one. The frame is forgotten and comes back as a new frame on its 			next reference_frame(), until then it must not be returned as a victim unless 			the pager scans all frames. Pagers without per frame bookkeeping keep nothing
+		*/
+		(void)frame;
+	}
+
+	virtual int reclaim_frames(Frame **victims, int count) {
+		/*
+			Function Name: reclaim_frames
+			Arguments:
+				Frame **victims: set to the frames selected
+				int count: number of victims wanted, at most the number of frames holding a page
+			Returns: int - number of victims selected, count
+			Description: selects several victims at once for the simulator to free, each one 			is released right away so it is not selected again. Victims are asked for one at 			a time. Frames without a page and frames selected earlier in the call, which 			pagers scanning all frames may return, are passed over. Pagers whose selection 			starts with a pass over all frames override it to make that pass once per call
+		*/
+		int n = 0;
+		while(n < count) {
+			Frame *frame = determine_victim_frame();
+			if(frame->process_id == -1 || std::find(victims, victims + n, frame) != victims + n) continue;
+			release_frame(frame);
+			victims[n++] = frame;
+		}
+		return n;
+	}
+
+	virtual ReferencedBitmap* referenced_bitmap() {
+		/*
+			Function Name: referenced_bitmap
+			Returns:
+				ReferencedBitmap*: referenced bits the pager keeps instead of the PTE of the 				first mapping of a frame, NULL if the pager uses the PTE
+		*/
+		return NULL;
+	}
+
+	virtual void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+			Description: saves or loads the bookkeeping of pager, pagers without any keep 			nothing
+		*/
+		(void)snapshot;
+	}
+
+	virtual ~Pager() {}
 };
 
 #endif
@@ -57,7 +145,7 @@ private:
 	int ind;
 
 public:
-	FIFOPager() {
+	FIFOPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random) {
 		ind = 0;
 	}
 
@@ -68,10 +156,21 @@ public:
 				Frame*: reference to frame selected by algorithm
 			Description: returns the frame to be used for memory requirements
 		*/
-		Frame *frame = frame_table[ind];
+		PROFILE_SCOPE("FIFOPager::determine_victim_frame");
+		Frame *frame = &frame_table[ind];
 		ind = (ind+1)%frame_limit;
 		return frame;
 	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(ind);
+	}
 };
 
 #endif
@@ -83,16 +182,15 @@ public:
 class SecondChancePager : public Pager {
 	/*
 		Class Name: SecondChancePager
-		Description: defines a class for pager allocating as per Second Chance Algorithm
+		Description: defines a class for pager allocating as per Second Chance Algorithm. 		Frames form a circular queue in frame number order, a frame given a second chance and 		a victim both move from head to tail, which keeps the order and only advances the 		head. The frame table itself is the ring, so a fault allocates nothing, and the 		frames given a second chance are skipped through a ReferencedBitmap.
 	*/
 private:
-	std::list<Frame*> second_chance_list;
+	int head; //frame at the head of queue
+	ReferencedBitmap referenced; //referenced bit of every frame
 
 public:
-	SecondChancePager() {
-		for(int i = 0; i < frame_limit; i++) {
-			second_chance_list.push_back(frame_table[i]);
-		}
+	SecondChancePager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random), referenced(frame_limit) {
+		head = 0;
 	}
 
 	Frame* determine_victim_frame() {
@@ -102,16 +200,39 @@ public:
 				Frame*: reference to frame selected by algorithm
 			Description: returns the frame to be used for memory requirements
 		*/
-		Frame *frame = second_chance_list.front();
-		while(processes[frame->process_id]->page_table[frame->page_number]->referenced) {
-			processes[frame->process_id]->page_table[frame->page_number]->referenced = 0;
-			second_chance_list.push_back(frame);
-			second_chance_list.pop_front();
-			frame = second_chance_list.front();
-		}
-		second_chance_list.pop_front();
-		second_chance_list.push_back(frame);
-		return frame;
+		PROFILE_SCOPE("SecondChancePager::determine_victim_frame");
+		int victim = referenced.advance(head);
+		head = (victim+1 == frame_limit) ? 0 : victim+1;
+		return &frame_table[victim];
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		referenced.set(frame->frame_number);
+	}
+
+	void release_frame(Frame *frame) {
+		referenced.clear(frame->frame_number);
+	}
+
+	ReferencedBitmap* referenced_bitmap() {
+		return &referenced;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(head);
+		referenced.state(snapshot);
 	}
 };
 
@@ -126,6 +247,9 @@ class RandomPager : public Pager {
 		Description: defines a class for pager allocating as per random allocation
 	*/
 public:
+	RandomPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random) {
+	}
+
 	Frame* determine_victim_frame() {
 		/*
 			Function Name: determine_victim_frame
@@ -133,8 +257,9 @@ public:
 				Frame*: reference to frame selected by algorithm
 			Description: returns the frame to be used for memory requirements
 		*/
+		PROFILE_SCOPE("RandomPager::determine_victim_frame");
 		int ind = myrandom(frame_limit); //get random frame number
-		return frame_table[ind];
+		return &frame_table[ind];
 	}
 };
 
@@ -144,16 +269,140 @@ public:
 #ifndef NRU_PAGER_H
 #define NRU_PAGER_H
 
+#define NRU_RESET_PERIOD 10 //referenced bits are cleared on every 10th fault
+
 class NRUPager : public Pager {
 	/*
 		Class Name: NRUPager
-		Description: defines a class for pager allocating as per NRU Algorithm
+		Description: defines a class for pager allocating as per NRU Algorithm. Frames are 		divided in 4 classes by referenced and modified bit of their page, victim is a random 		frame of lowest non-empty class, picked by its position in frame number order.
+
+		Classes are kept up to date incrementally from reference_frame(). For each value of 		modified bit one tree counts all frames and another the referenced frames, so a 		class and the k-th frame in it are found in O(log frames). Referenced trees are 		versioned by epoch, so clearing all referenced bits is an epoch increment.
 	*/
 private:
 	int clock; //keep track of clock to clear references
+	FenwickTree frames_by_modified[2]; //frames in memory, by modified bit
+	FenwickTree referenced_by_modified[2]; //referenced frames, by modified bit, cleared every epoch
+	std::vector<char> modified; //modified bit of frame as last seen, -1 if never seen
+	std::vector<unsigned int> referenced_epoch; //epoch in which frame was last referenced
+	std::vector<int> referenced_frames; //frames referenced in current epoch
+	unsigned int epoch; //current epoch, frames referenced in earlier epochs count as not referenced
+
+	int select(int m, bool referenced, int k) {
+		/*
+			Function Name: select
+			Arguments:
+				int m: modified bit of class
+				bool referenced: referenced bit of class
+				int k: position in class
+			Returns:
+				int: frame number of k-th frame (counting from 0) of class in frame number order
+			Description: descends both trees of modified bit m at once
+		*/
+		FenwickTree &all = frames_by_modified[m];
+		FenwickTree &ref = referenced_by_modified[m];
+		int pos = 0;
+		for(int step = all.top_step(); step > 0; step >>= 1) {
+			if(pos + step > all.size()) continue;
+			int count = referenced ? ref.node(pos + step) : all.node(pos + step) - ref.node(pos + step);
+			if(count <= k) {
+				pos += step;
+				k -= count;
+			}
+		}
+		return pos;
+	}
+
+	Frame* pick() {
+		/*
+			Function Name: pick
+			Returns:
+				Frame*: random frame of lowest non-empty class
+		*/
+		//class sizes, in order of preference
+		int sizes[4];
+		for(int m = 0; m < 2; m++) {
+			sizes[m] = frames_by_modified[m].total() - referenced_by_modified[m].total();
+			sizes[2 + m] = referenced_by_modified[m].total();
+		}
+
+		for(int c = 0; c < 3; c++) {
+			if(sizes[c] != 0) return &frame_table[select(c % 2, c >= 2, myrandom(sizes[c]))];
+		}
+		return &frame_table[select(1, true, myrandom(sizes[3]))];
+	}
+
+	void reset() {
+		/*
+			Function Name: reset
+			Returns: void
+			Description: clears the referenced bits of all pages on every NRU_RESET_PERIOD-th 			call, the trees are cleared by starting a new epoch. Frames freed since their 			reference have no page whose bit could be cleared.
+		*/
+		if(clock != 0) return;
+		for(int i = 0; i < (int)referenced_frames.size(); i++) {
+			Frame *frame = &frame_table[referenced_frames[i]];
+			if(frame->process_id != -1) frame->pte->referenced = 0;
+		}
+		referenced_frames.clear();
+		referenced_by_modified[0].clear();
+		referenced_by_modified[1].clear();
+		epoch++;
+	}
+
 public:
-	NRUPager() {
+	NRUPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random) {
 		clock = 0;
+		epoch = 1;
+		for(int m = 0; m < 2; m++) {
+			frames_by_modified[m].resize(frame_limit);
+			referenced_by_modified[m].resize(frame_limit);
+		}
+		modified.assign(frame_limit, -1);
+		referenced_epoch.assign(frame_limit, 0);
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+			Description: moves the frame into the class of its page's current bits
+		*/
+		int f = frame->frame_number;
+		int m = frame->pte->modified;
+		bool referenced = (referenced_epoch[f] == epoch);
+
+		if(modified[f] != m) {
+			if(modified[f] != -1) {
+				frames_by_modified[(int)modified[f]].add(f, -1);
+				if(referenced) referenced_by_modified[(int)modified[f]].add(f, -1);
+			}
+			frames_by_modified[m].add(f, 1);
+			if(referenced) referenced_by_modified[m].add(f, 1);
+			modified[f] = m;
+		}
+
+		if(!referenced) {
+			referenced_by_modified[m].add(f, 1);
+			referenced_epoch[f] = epoch;
+			referenced_frames.push_back(f);
+		}
+	}
+
+	void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed
+			Returns: void
+			Description: takes the frame out of its class. It stays in referenced_frames, 			by the next reset it holds a page again.
+		*/
+		int f = frame->frame_number;
+		if(modified[f] == -1) return;
+		frames_by_modified[(int)modified[f]].add(f, -1);
+		if(referenced_epoch[f] == epoch) referenced_by_modified[(int)modified[f]].add(f, -1);
+		modified[f] = -1;
+		referenced_epoch[f] = 0;
 	}
 
 	Frame* determine_victim_frame() {
@@ -163,66 +412,48 @@ public:
 				Frame*: reference to frame selected by algorithm
 			Description: returns the frame to be used for memory requirements
 		*/
-		std::vector <Frame*> class_1;
-		std::vector <Frame*> class_2;
-		std::vector <Frame*> class_3;
-		std::vector <Frame*> class_4;
-		
-		clock = (clock+1)%10;
-
-		unsigned int selector;
-		Frame *frame;
-
-		
-		
-		for(int i = 0; i < frame_limit; i++) {
-			frame = frame_table[i];
-			selector = 2*processes[frame->process_id]->page_table[frame->page_number]->referenced + processes[frame->process_id]->page_table[frame->page_number]->modified;
-			switch(selector) {
-				case 0:
-					class_1.push_back(frame);
-					break;
-				case 1:
-					class_2.push_back(frame);
-					break;
-				case 2:
-					class_3.push_back(frame);
-					break;
-				case 3:
-					class_4.push_back(frame);
-					break;
-			}
-		}
-
-		int ind;
-		if(class_1.size() != 0) {
-			ind = myrandom(class_1.size());
+		PROFILE_SCOPE("NRUPager::determine_victim_frame");
+		clock = (clock+1)%NRU_RESET_PERIOD;
+		Frame *frame = pick();
+		reset();
+		return frame;
+	}
 
-			frame = class_1.at(ind);
-		} else if(class_2.size() != 0) {
-			ind = myrandom(class_2.size());
-			frame = class_2.at(ind);
-		} else if(class_3.size() != 0) {
-			ind = myrandom(class_3.size());
-			frame = class_3.at(ind);
-		} else {
-			ind = myrandom(class_4.size());
-			frame = class_4.at(ind);
+	int reclaim_frames(Frame **victims, int count) {
+		/*
+			Function Name: reclaim_frames
+			Arguments:
+				Frame **victims: set to the frames selected
+				int count: number of victims wanted, at most the number of frames in classes
+			Returns: int - number of victims selected, count
+			Description: a batch counts as one call towards the reset of referenced bits, 			every victim is taken out of its class before the next one is picked
+		*/
+		PROFILE_SCOPE("NRUPager::reclaim_frames");
+		clock = (clock+1)%NRU_RESET_PERIOD;
+		for(int n = 0; n < count; n++) {
+			victims[n] = pick();
+			release_frame(victims[n]);
 		}
+		reset();
+		return count;
+	}
 
-		Frame *temp;
-		if(clock == 0) {
-			for(int i = 0; i < class_3.size(); i++) {
-				temp = class_3.at(i);
-				processes[temp->process_id]->page_table[temp->page_number]->referenced = 0;
-			}
-			for(int i = 0; i < class_4.size(); i++) {
-				temp = class_4.at(i);
-				processes[temp->process_id]->page_table[temp->page_number]->referenced = 0;
-			}
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(clock);
+		for(int m = 0; m < 2; m++) {
+			frames_by_modified[m].state(snapshot);
+			referenced_by_modified[m].state(snapshot);
 		}
-
-		return frame;
+		snapshot.field(modified);
+		snapshot.field(referenced_epoch);
+		snapshot.field(referenced_frames);
+		snapshot.field(epoch);
 	}
 };
 
@@ -236,13 +467,14 @@ public:
 class ClockPager : public Pager {
 	/*
 		Class Name: ClockPager
-		Description: defines a class for pager allocating as per Clock Algorithm
+		Description: defines a class for pager allocating as per Clock Algorithm. The hand 		skips referenced frames through a ReferencedBitmap.
 	*/
 private:
 	int ind;
+	ReferencedBitmap referenced; //referenced bit of every frame
 
 public:
-	ClockPager() {
+	ClockPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random), referenced(frame_limit) {
 		ind = 0;
 	}
 
@@ -253,14 +485,39 @@ public:
 				Frame*: reference to frame selected by algorithm
 			Description: returns the frame to be used for memory requirements
 		*/
-		Frame *frame = frame_table[ind];
-		while(processes[frame->process_id]->page_table[frame->page_number]->referenced) {
-			processes[frame->process_id]->page_table[frame->page_number]->referenced = 0;
-			ind = (ind+1)%frame_limit;
-			frame = frame_table[ind];
-		}
-		ind = (ind+1)%frame_limit;
-		return frame;
+		PROFILE_SCOPE("ClockPager::determine_victim_frame");
+		int victim = referenced.advance(ind);
+		ind = (victim+1)%frame_limit;
+		return &frame_table[victim];
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		referenced.set(frame->frame_number);
+	}
+
+	void release_frame(Frame *frame) {
+		referenced.clear(frame->frame_number);
+	}
+
+	ReferencedBitmap* referenced_bitmap() {
+		return &referenced;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(ind);
+		referenced.state(snapshot);
 	}
 };
 
@@ -269,12 +526,261 @@ public:
 #ifndef AGING_PAGER_H
 #define AGING_PAGER_H
 
+#define AGE_BITS 32 //width of age counter
+#define AGE_NONE -1 //bucket of frames whose age has decayed to 0
+#define AGE_FREE -2 //bucket of frames without a page, never a victim
+
 class AgingPager : public Pager {
 	/*
 		Class Name: AgingPager
-		Description: defines a class for pager allocating as per Aging Algorithm
+		Description: defines a class for pager allocating as per Aging Algorithm. On every 		fault the age of every frame is shifted right and the referenced bit is put in its 		top bit, victim is the frame with least age (lowest frame number on ties).
+
+		Ages are shifted lazily. A frame keeps the age it had at the tick it was last 		referenced, its current age is that age shifted by the ticks since. Frames referenced 		at the same tick are kept in a bucket, there are AGE_BITS buckets for the last 		AGE_BITS ticks and frames older than that have age 0. So a fault only touches frames 		referenced since the previous fault, and the victim is always in the oldest 		non-empty bucket.
+
+		A bucket is filled once, at its tick, and frames only leave it afterwards. Its frames 		are grouped by age, groups in order of age. As ages are shifted, groups whose ages 		differ in the bits shifted out tie, and once tied they stay tied. The frames of the 		leading groups of the oldest bucket that tie are kept in a bitmap, each group is 		added to it once, so the victim is its lowest frame whatever the number of groups. 		Frames of age 0 are kept in a bitmap too.
 	*/
+private:
+	unsigned long int tick; //number of faults handled
+	std::vector<unsigned int> age; //age of frame at its last referenced tick
+	std::vector<unsigned long int> last_tick; //tick at which frame was last referenced
+	std::vector<int> bucket; //bucket holding the frame, AGE_NONE if age is 0, AGE_FREE if it has no page
+	std::vector<int> group; //group holding the frame if it is in a bucket
+	std::vector<int> next, prev; //links of frames in a group, in order of frame number, -1 terminated
+	std::vector<int> group_first; //first frame of every group, -1 for a group not in use
+	std::vector<int> group_next, group_prev; //links of groups in a bucket in order of age, -1 terminated
+	int free_groups; //groups not in use, linked by group_next
+	int head[AGE_BITS]; //first group of each bucket, bucket of tick t is t%AGE_BITS
+	uint32_t occupied; //bit b is set if bucket b holds a frame
+	BitTree zero_age; //frames whose age is 0
+	BitTree tied; //frames of the leading groups of tied_bucket whose ages tie
+	std::vector<bool> group_tied; //whether the frames of group are in tied
+	int tied_bucket; //bucket tied is kept for, the oldest one, -1 if none
+	int tied_next; //first group of tied_bucket not in tied, -1 if all are
+	std::vector<int> touched; //frames referenced since last fault
+	std::vector<bool> is_touched; //whether frame is in touched
+	std::vector<std::pair<unsigned int, int> > shifted_ages; //touched frames by age before their reference, reused every tick
+
+	void unlink(int f) {
+		/*
+			Function Name: unlink
+			Arguments:
+				int f: frame number
+			Returns: void
+			Description: removes frame from its group, or from the set of 0 age frames. A 			group left empty leaves its bucket.
+		*/
+		if(bucket[f] == AGE_FREE) return;
+		if(bucket[f] == AGE_NONE) {
+			zero_age.erase(f);
+			return;
+		}
+		int g = group[f];
+		if(group_tied[g]) tied.erase(f);
+		if(prev[f] != -1) next[prev[f]] = next[f];
+		else group_first[g] = next[f];
+		if(next[f] != -1) prev[next[f]] = prev[f];
+		if(group_first[g] != -1) return;
+
+		int b = bucket[f];
+		if(g == tied_next) tied_next = group_next[g];
+		if(group_prev[g] != -1) group_next[group_prev[g]] = group_next[g];
+		else head[b] = group_next[g];
+		if(group_next[g] != -1) group_prev[group_next[g]] = group_prev[g];
+		group_next[g] = free_groups;
+		free_groups = g;
+		if(head[b] == -1) {
+			occupied &= ~(1u << b);
+			if(b == tied_bucket) tied_bucket = -1;
+		}
+	}
+
+	void decay(int b) {
+		/*
+			Function Name: decay
+			Arguments:
+				int b: bucket of the tick AGE_BITS ticks ago
+			Returns: void
+			Description: the frames of bucket have age 0 now, its groups are not used any more
+		*/
+		int g = head[b];
+		while(g != -1) {
+			for(int f = group_first[g]; f != -1; f = next[f]) {
+				bucket[f] = AGE_NONE;
+				zero_age.insert(f);
+				if(group_tied[g]) tied.erase(f);
+			}
+			int following = group_next[g];
+			group_first[g] = -1;
+			group_next[g] = free_groups;
+			free_groups = g;
+			g = following;
+		}
+		head[b] = -1;
+		occupied &= ~(1u << b);
+		if(b == tied_bucket) tied_bucket = -1;
+	}
+
 public:
+	AgingPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random) {
+		tick = 0;
+		age.assign(frame_limit, 0);
+		last_tick.assign(frame_limit, 0);
+		bucket.assign(frame_limit, AGE_FREE);
+		group.assign(frame_limit, -1);
+		next.assign(frame_limit, -1);
+		prev.assign(frame_limit, -1);
+		is_touched.assign(frame_limit, false);
+
+		//every frame may be in a group of its own
+		group_first.assign(frame_limit, -1);
+		group_tied.assign(frame_limit, false);
+		group_prev.assign(frame_limit, -1);
+		group_next.resize(frame_limit);
+		for(int g = 0; g < frame_limit; g++) group_next[g] = g + 1;
+		if(frame_limit > 0) group_next[frame_limit - 1] = -1;
+		free_groups = (frame_limit > 0) ? 0 : -1;
+
+		for(int b = 0; b < AGE_BITS; b++) head[b] = -1;
+		occupied = 0;
+		zero_age.resize(frame_limit);
+		tied.resize(frame_limit);
+		tied_bucket = -1;
+		tied_next = -1;
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+			Description: remembers the frame so its age is updated on next fault
+		*/
+		int f = frame->frame_number;
+		if(!is_touched[f]) {
+			is_touched[f] = true;
+			touched.push_back(f);
+		}
+	}
+
+	void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed
+			Returns: void
+			Description: the frame gets age 0 and leaves the buckets until it holds a page 			again. If it is in touched, it is passed over by the next fault unless it holds 			a page by then.
+		*/
+		int f = frame->frame_number;
+		unlink(f);
+		bucket[f] = AGE_FREE;
+		age[f] = 0;
+	}
+
+	unsigned int get_age(int f) {
+		/*
+			Function Name: get_age
+			Arguments:
+				int f: frame number
+			Returns:
+				unsigned int: age of frame as of the last fault
+		*/
+		if(bucket[f] < 0) return 0;
+		return age[f] >> (tick - last_tick[f]);
+	}
+
+	void advance() {
+		/*
+			Function Name: advance
+			Returns: void
+			Description: starts the next tick, the referenced bit of every frame referenced 			since the last one is shifted into its age
+		*/
+		tick++;
+
+		//frames last referenced AGE_BITS ticks ago have decayed to 0,
+		//this also empties the bucket for the current tick
+		int b = tick % AGE_BITS;
+		decay(b);
+
+		//shift referenced bit into the age of every frame referenced since last fault. New
+		//ages are ordered as the shifted ones, so the bucket is filled in order
+		shifted_ages.clear();
+		for(int i = 0; i < (int)touched.size(); i++) {
+			int f = touched[i];
+			is_touched[f] = false;
+			if(frame_table[f].process_id == -1) continue;
+			unsigned int shifted = (bucket[f] < 0) ? 0 : age[f] >> (tick - last_tick[f]);
+			shifted_ages.push_back(std::make_pair(shifted, f));
+		}
+		touched.clear();
+		std::sort(shifted_ages.begin(), shifted_ages.end());
+
+		int g = -1; //group being filled
+		int last = -1; //last frame of group being filled
+		for(int i = 0; i < (int)shifted_ages.size(); i++) {
+			int f = shifted_ages[i].second;
+			unlink(f);
+			age[f] = shifted_ages[i].first | (1u << (AGE_BITS - 1));
+			last_tick[f] = tick;
+			bucket[f] = b;
+			frame_table[f].pte->referenced = 0;
+
+			//a frame of another age starts a new group after the last one
+			if(g == -1 || age[f] != age[last]) {
+				int previous = g;
+				g = free_groups;
+				free_groups = group_next[g];
+				group_prev[g] = previous;
+				group_next[g] = -1;
+				group_tied[g] = false;
+				if(previous != -1) group_next[previous] = g;
+				else head[b] = g;
+				group_first[g] = f;
+				prev[f] = -1;
+			} else {
+				next[last] = f;
+				prev[f] = last;
+			}
+			next[f] = -1;
+			group[f] = g;
+			last = f;
+		}
+		if(head[b] != -1) occupied |= 1u << b;
+	}
+
+	Frame* oldest() {
+		/*
+			Function Name: oldest
+			Returns:
+				Frame*: frame with least age, lowest frame number on ties
+		*/
+		//frames with 0 age are the oldest
+		if(!zero_age.empty()) {
+			return &frame_table[zero_age.lowest()];
+		}
+		if(occupied == 0) return NULL;
+
+		//otherwise the oldest bucket, buckets are searched from the one of tick-AGE_BITS+1 on
+		//with the occupied bits rotated to start there
+		int first = (tick + 1) % AGE_BITS;
+		uint64_t rotated = (((uint64_t)occupied << AGE_BITS) | occupied) >> first;
+		int b = (first + __builtin_ctzll(rotated)) % AGE_BITS;
+		int shift = (tick - b) % AGE_BITS;
+
+		//the first group has the least age, following groups that tie with it at this shift
+		//join tied and stay in it, as a larger shift only makes more groups tie
+		if(b != tied_bucket) {
+			tied_bucket = b;
+			tied_next = head[b];
+		}
+		unsigned int least = age[group_first[head[b]]] >> shift;
+		while(tied_next != -1 && (age[group_first[tied_next]] >> shift) == least) {
+			for(int f = group_first[tied_next]; f != -1; f = next[f]) tied.insert(f);
+			group_tied[tied_next] = true;
+			tied_next = group_next[tied_next];
+		}
+		return &frame_table[tied.lowest()];
+	}
+
 	Frame* determine_victim_frame() {
 		/*
 			Function Name: determine_victim_frame
@@ -282,24 +788,932 @@ public:
 				Frame*: reference to frame selected by algorithm
 			Description: returns the frame to be used for memory requirements
 		*/
-		for(int i = 0; i < frame_limit; i++) {
-			age.at(i) = (age.at(i) >> 1) | (processes[frame_table[i]->process_id]->page_table[frame_table[i]->page_number]->referenced << 31);
-			processes[frame_table[i]->process_id]->page_table[frame_table[i]->page_number]->referenced = 0;
+		PROFILE_SCOPE("AgingPager::determine_victim_frame");
+		advance();
+		return oldest();
+	}
+
+	int reclaim_frames(Frame **victims, int count) {
+		/*
+			Function Name: reclaim_frames
+			Arguments:
+				Frame **victims: set to the frames selected
+				int count: number of victims wanted, at most the number of frames holding a page
+			Returns: int - number of victims selected, count
+			Description: a batch is a single tick, victims are the count oldest frames
+		*/
+		PROFILE_SCOPE("AgingPager::reclaim_frames");
+		advance();
+		for(int n = 0; n < count; n++) {
+			victims[n] = oldest();
+			release_frame(victims[n]);
+		}
+		return count;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		snapshot.field(tick);
+		snapshot.field(age);
+		snapshot.field(last_tick);
+		snapshot.field(bucket);
+		snapshot.field(group);
+		snapshot.field(next);
+		snapshot.field(prev);
+		snapshot.field(group_first);
+		snapshot.field(group_next);
+		snapshot.field(group_prev);
+		snapshot.field(free_groups);
+		snapshot.field(head);
+		snapshot.field(occupied);
+		zero_age.state(snapshot);
+		tied.state(snapshot);
+		snapshot.field(group_tied);
+		snapshot.field(tied_bucket);
+		snapshot.field(tied_next);
+		snapshot.field(touched);
+		snapshot.field(is_touched);
+	}
+};
+
+
+#endif
+
+#ifndef LRU_PAGER_H
+#define LRU_PAGER_H
+
+class LRUPager : public Pager {
+	/*
+		Class Name: LRUPager
+		Description: defines a class for pager allocating as per exact LRU. Frames are kept in 		a list in order of last reference, the page table already maps a page to its frame so 		a reference moves its frame to the front in O(1).
+	*/
+private:
+	LinkedLists recency; //list 0: frames, most recently referenced first
+
+public:
+	LRUPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random), recency(frame_limit, 1) {
+	}
+
+	Frame* determine_victim_frame() {
+		/*
+			Function Name: determine_victim_frame
+			Returns: 
+				Frame*: reference to frame selected by algorithm
+			Description: returns the least recently referenced frame
+		*/
+		PROFILE_SCOPE("LRUPager::determine_victim_frame");
+		int f = recency.back(0);
+		recency.remove(f);
+		return &frame_table[f];
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		int f = frame->frame_number;
+		if(recency.list_of(f) != -1) recency.remove(f);
+		recency.push_front(0, f);
+	}
+
+	void release_frame(Frame *frame) {
+		if(recency.list_of(frame->frame_number) != -1) recency.remove(frame->frame_number);
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		recency.state(snapshot);
+	}
+};
+
+#endif
+
+
+#ifndef LFU_PAGER_H
+#define LFU_PAGER_H
+
+class LFUPager : public Pager {
+	/*
+		Class Name: LFUPager
+		Description: defines a class for pager allocating as per LFU. Counts the references 		to a page since it was loaded, victim is the frame with least count, least recently 		referenced among equal counts. Frames with equal count share a bucket and buckets are 		kept in ascending order of count, so a reference moves its frame to the next bucket 		in O(1).
+	*/
+private:
+	LinkedLists frames; //list b: frames of bucket b, most recently referenced first
+	LinkedLists buckets; //list 0: buckets in use, ascending count
+	std::vector<unsigned long int> bucket_count; //reference count of frames in bucket
+	std::vector<int> free_buckets; //buckets not in use
+	std::vector<int> bucket_of; //bucket of every frame, -1 if its page was just loaded
+
+	int new_bucket(unsigned long int count) {
+		/*
+			Function Name: new_bucket
+			Arguments:
+				unsigned long int count: reference count of bucket
+			Returns:
+				int: unused bucket, not yet linked
+		*/
+		int b = free_buckets.back();
+		free_buckets.pop_back();
+		bucket_count[b] = count;
+		return b;
+	}
+
+	void move_to_bucket(int f, int b) {
+		/*
+			Function Name: move_to_bucket
+			Arguments:
+				int f: frame
+				int b: bucket frame goes to, its old bucket is released if left empty
+			Returns: void
+		*/
+		int old = bucket_of[f];
+		if(old != -1) {
+			frames.remove(f);
+			if(frames.size(old) == 0) {
+				buckets.remove(old);
+				free_buckets.push_back(old);
+			}
+		}
+		frames.push_front(b, f);
+		bucket_of[f] = b;
+	}
+
+public:
+	//one more bucket than frames, a new bucket is taken before the old one is released
+	LFUPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : Pager(frame_table, frame_limit, random), frames(frame_limit, frame_limit + 1), buckets(frame_limit + 1, 1), bucket_count(frame_limit + 1, 0), bucket_of(frame_limit, -1) {
+		for(int b = frame_limit; b >= 0; b--) {
+			free_buckets.push_back(b);
+		}
+	}
+
+	Frame* determine_victim_frame() {
+		/*
+			Function Name: determine_victim_frame
+			Returns: 
+				Frame*: reference to frame selected by algorithm
+			Description: returns the least recently referenced frame of the lowest count
+		*/
+		PROFILE_SCOPE("LFUPager::determine_victim_frame");
+		int b = buckets.front(0);
+		int f = frames.back(b);
+		frames.remove(f);
+		if(frames.size(b) == 0) {
+			buckets.remove(b);
+			free_buckets.push_back(b);
+		}
+		bucket_of[f] = -1;
+		return &frame_table[f];
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		int f = frame->frame_number;
+		int b = bucket_of[f];
+
+		//a page just loaded has count 1
+		if(b == -1) {
+			int first = buckets.front(0);
+			if(first == -1 || bucket_count[first] != 1) {
+				first = new_bucket(1);
+				buckets.push_front(0, first);
+			}
+			move_to_bucket(f, first);
+			return;
+		}
+
+		int next = buckets.next_of(b);
+		if(next == -1 || bucket_count[next] != bucket_count[b] + 1) {
+			next = new_bucket(bucket_count[b] + 1);
+			buckets.insert_after(b, next);
+		}
+		move_to_bucket(f, next);
+	}
+
+	void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed
+			Returns: void
+			Description: takes the frame out of its bucket as a victim is
+		*/
+		int f = frame->frame_number;
+		int b = bucket_of[f];
+		if(b == -1) return;
+		frames.remove(f);
+		if(frames.size(b) == 0) {
+			buckets.remove(b);
+			free_buckets.push_back(b);
+		}
+		bucket_of[f] = -1;
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		frames.state(snapshot);
+		buckets.state(snapshot);
+		snapshot.field(bucket_count);
+		snapshot.field(free_buckets);
+		snapshot.field(bucket_of);
+	}
+};
+
+#endif
+
+
+#ifndef HISTORY_PAGER_H
+#define HISTORY_PAGER_H
+
+class HistoryPager : public Pager {
+	/*
+		Class Name: HistoryPager
+		Description: defines a parent class for pagers that remember pages they evicted. 		Frames and ghosts, i.e. evicted pages, are nodes of the same lists: nodes 		0..frame_limit-1 are the frames, the following ones are ghosts. A ghost holds the key 		of its page and is found from the key through a hash map.
+	*/
+protected:
+	LinkedLists lists; //lists of frames and ghosts, defined by subclass
+	std::vector<uint64_t> ghost_key; //key of page of every ghost, indexed by node-frame_limit
+	std::vector<int> free_ghosts; //ghost nodes not in use
+	std::unordered_map<uint64_t, int> ghosts; //ghost node of every remembered page
+	uint64_t fault_key; //key of page of last fault
+
+	static uint64_t key(int process_id, int page_number) {
+		return ((uint64_t)process_id << 32) | (uint32_t)page_number;
+	}
+
+	uint64_t frame_key(Frame *frame) {
+		return key(frame->process_id, frame->page_number);
+	}
+
+	int find_ghost(uint64_t k) {
+		/*
+			Function Name: find_ghost
+			Arguments:
+				uint64_t k: key of page
+			Returns:
+				int: ghost node of page, -1 if it is not remembered
+		*/
+		std::unordered_map<uint64_t, int>::iterator it = ghosts.find(k);
+		return (it == ghosts.end()) ? -1 : it->second;
+	}
+
+	int add_ghost(uint64_t k) {
+		/*
+			Function Name: add_ghost
+			Arguments:
+				uint64_t k: key of evicted page
+			Returns:
+				int: ghost node remembering page, to be linked by caller
+		*/
+		int g = free_ghosts.back();
+		free_ghosts.pop_back();
+		ghost_key[g - frame_limit] = k;
+		ghosts[k] = g;
+		return g;
+	}
+
+	void drop_ghost(int g) {
+		/*
+			Function Name: drop_ghost
+			Arguments:
+				int g: ghost node, unlinked if it is in a list
+			Returns: void
+			Description: forgets the page of ghost
+		*/
+		if(lists.list_of(g) != -1) lists.remove(g);
+		ghosts.erase(ghost_key[g - frame_limit]);
+		free_ghosts.push_back(g);
+	}
+
+public:
+	HistoryPager(Frame *frame_table, int frame_limit, RandomGenerator *random, int num_lists, int num_ghosts) : Pager(frame_table, frame_limit, random), lists(frame_limit + num_ghosts, num_lists), ghost_key(num_ghosts) {
+		/*
+			Function Name: constructor
+			Arguments:
+				Frame *frame_table: frame table of simulator
+				int frame_limit: number of frames in frame table
+				RandomGenerator *random: random numbers of simulator
+				int num_lists: number of lists of subclass
+				int num_ghosts: largest number of pages remembered at once
+			Description: Initializes all the members of class
+		*/
+		for(int g = frame_limit + num_ghosts - 1; g >= frame_limit; g--) {
+			free_ghosts.push_back(g);
+		}
+		ghosts.reserve(num_ghosts);
+		fault_key = 0;
+	}
+
+	void page_fault(int process_id, int page_number) {
+		fault_key = key(process_id, page_number);
+	}
+
+	void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed
+			Returns: void
+			Description: takes the frame out of its list, the page is gone for good so no 			ghost remembers it
+		*/
+		if(lists.list_of(frame->frame_number) != -1) lists.remove(frame->frame_number);
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		lists.state(snapshot);
+		snapshot.field(ghost_key);
+		snapshot.field(free_ghosts);
+		snapshot.field(ghosts);
+		snapshot.field(fault_key);
+	}
+};
+
+#endif
+
+
+#ifndef TWO_Q_PAGER_H
+#define TWO_Q_PAGER_H
+
+#define TWO_Q_A1IN 0 //frames referenced once, FIFO
+#define TWO_Q_AM 1 //frames referenced again after eviction from A1in, LRU
+#define TWO_Q_A1OUT 2 //ghosts evicted from A1in, FIFO
+
+class TwoQPager : public HistoryPager {
+	/*
+		Class Name: TwoQPager
+		Description: defines a class for pager allocating as per full 2Q (Johnson and Shasha). 		A new page enters FIFO A1in, pages evicted from A1in are remembered in A1out, a page 		faulted again while in A1out enters LRU Am. A1in is kept at 1/4 of memory and A1out 		remembers 1/2 of memory worth of pages.
+	*/
+private:
+	int kin; //target size of A1in
+	int kout; //size of A1out
+
+public:
+	TwoQPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : HistoryPager(frame_table, frame_limit, random, 3, frame_limit/2 + 1) {
+		kin = frame_limit/4 > 0 ? frame_limit/4 : 1;
+		kout = frame_limit/2 > 0 ? frame_limit/2 : 1;
+	}
+
+	Frame* determine_victim_frame() {
+		/*
+			Function Name: determine_victim_frame
+			Returns: 
+				Frame*: reference to frame selected by algorithm
+			Description: evicts from A1in while it is above its target, remembering the page in 			A1out, otherwise evicts least recently used frame of Am
+		*/
+		PROFILE_SCOPE("TwoQPager::determine_victim_frame");
+		int f;
+		if(lists.size(TWO_Q_A1IN) > kin || lists.size(TWO_Q_AM) == 0) {
+			f = lists.back(TWO_Q_A1IN);
+			lists.remove(f);
+			if(lists.size(TWO_Q_A1OUT) == kout) drop_ghost(lists.back(TWO_Q_A1OUT));
+			lists.push_front(TWO_Q_A1OUT, add_ghost(frame_key(&frame_table[f])));
+		} else {
+			f = lists.back(TWO_Q_AM);
+			lists.remove(f);
+		}
+		return &frame_table[f];
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		int f = frame->frame_number;
+		int l = lists.list_of(f);
+		if(l == TWO_Q_AM) {
+			lists.remove(f);
+			lists.push_front(TWO_Q_AM, f);
+		} else if(l == -1) {
+			//page was just loaded
+			int g = find_ghost(frame_key(frame));
+			if(g != -1) {
+				drop_ghost(g);
+				lists.push_front(TWO_Q_AM, f);
+			} else {
+				lists.push_front(TWO_Q_A1IN, f);
+			}
+		}
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		HistoryPager::state(snapshot);
+		snapshot.field(kin);
+		snapshot.field(kout);
+	}
+};
+
+#endif
+
+
+#ifndef ARC_PAGER_H
+#define ARC_PAGER_H
+
+#define ARC_T1 0 //frames referenced once recently, LRU
+#define ARC_T2 1 //frames referenced at least twice recently, LRU
+#define ARC_B1 2 //ghosts evicted from T1, LRU
+#define ARC_B2 3 //ghosts evicted from T2, LRU
+
+class ARCPager : public HistoryPager {
+	/*
+		Class Name: ARCPager
+		Description: defines a class for pager allocating as per ARC (Megiddo and Modha). 		Resident pages are split between T1 (seen once) and T2 (seen again), ghosts of pages 		evicted from them are kept in B1 and B2. A fault on a ghost of B1 grows the target 		size p of T1, one on a ghost of B2 shrinks it, and victims come from T1 or T2 so as 		to meet p.
+	*/
+private:
+	int p; //target size of T1
+	bool adapted; //whether p was adapted to the page of last fault
+	bool adapt_on_free; //whether a ghost hit that gets a free frame adapts p
+
+	void adapt(int g) {
+		/*
+			Function Name: adapt
+			Arguments:
+				int g: ghost of the faulting page
+			Returns: void
+			Description: grows p on a ghost of B1, shrinks it on a ghost of B2
+		*/
+		int b1 = lists.size(ARC_B1), b2 = lists.size(ARC_B2);
+		if(lists.list_of(g) == ARC_B1) {
+			p += (b2/b1 > 1) ? b2/b1 : 1;
+			if(p > frame_limit) p = frame_limit;
+		} else {
+			p -= (b1/b2 > 1) ? b1/b2 : 1;
+			if(p < 0) p = 0;
+		}
+		adapted = true;
+	}
+
+	int replace(bool in_b2) {
+		/*
+			Function Name: replace
+			Arguments:
+				bool in_b2: whether the faulting page is remembered in B2
+			Returns:
+				int: frame evicted from T1 or T2, its page is remembered in B1 or B2
+		*/
+		int t1 = lists.size(ARC_T1);
+		int from = ARC_T2, to = ARC_B2;
+		if((t1 >= 1 && ((in_b2 && t1 == p) || t1 > p)) || lists.size(ARC_T2) == 0) {
+			from = ARC_T1;
+			to = ARC_B1;
+		}
+		int f = lists.back(from);
+		lists.remove(f);
+		lists.push_front(to, add_ghost(frame_key(&frame_table[f])));
+		return f;
+	}
+
+public:
+	//a ghost hit is removed after the replacement, so one more ghost than frames. kswapd
+	//frees frames ahead of most faults, p would hardly adapt unless hits on free frames do
+	ARCPager(Frame *frame_table, int frame_limit, RandomGenerator *random, bool adapt_on_free = false) : HistoryPager(frame_table, frame_limit, random, 4, frame_limit + 1) {
+		p = 0;
+		adapted = false;
+		this->adapt_on_free = adapt_on_free;
+	}
+
+	void page_fault(int process_id, int page_number) {
+		fault_key = key(process_id, page_number);
+		adapted = false;
+	}
+
+	Frame* determine_victim_frame() {
+		/*
+			Function Name: determine_victim_frame
+			Returns: 
+				Frame*: reference to frame selected by algorithm
+			Description: adapts p if the faulting page is a ghost and evicts as per ARC
+		*/
+		PROFILE_SCOPE("ARCPager::determine_victim_frame");
+		int c = frame_limit;
+		int b1 = lists.size(ARC_B1), b2 = lists.size(ARC_B2);
+		int g = find_ghost(fault_key);
+
+		//p is adapted once per fault, here or when the page is referenced
+		if(g != -1 && !adapted) {
+			bool in_b2 = (lists.list_of(g) == ARC_B2);
+			adapt(g);
+			return &frame_table[replace(in_b2)];
+		}
+
+		//page is not remembered, keep T1+B1 and all lists within bounds. Frames freed by exit
+		//and exec are refilled without a victim, so the bounds may be overshot
+		if(lists.size(ARC_T1) + b1 >= c) {
+			if(lists.size(ARC_T1) < c) {
+				drop_ghost(lists.back(ARC_B1));
+				return &frame_table[replace(false)];
+			}
+			int f = lists.back(ARC_T1);
+			lists.remove(f);
+			return &frame_table[f];
+		}
+		if(b1 + b2 >= c) drop_ghost(lists.back((b2 > 0) ? ARC_B2 : ARC_B1));
+		return &frame_table[replace(false)];
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		int f = frame->frame_number;
+		if(lists.list_of(f) != -1) {
+			lists.remove(f);
+			lists.push_front(ARC_T2, f);
+			return;
+		}
+
+		//page was just loaded, it is seen again if it is remembered. A page that got a free
+		//frame adapts p here with kswapd, as no victim was asked for
+		int g = find_ghost(frame_key(frame));
+		if(g != -1) {
+			if(adapt_on_free && !adapted) adapt(g);
+			drop_ghost(g);
+			lists.push_front(ARC_T2, f);
+		} else {
+			lists.push_front(ARC_T1, f);
+		}
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		HistoryPager::state(snapshot);
+		snapshot.field(p);
+		snapshot.field(adapted);
+	}
+};
+
+#endif
+
+
+#ifndef CLOCK_PRO_PAGER_H
+#define CLOCK_PRO_PAGER_H
+
+#define CLOCK_PRO_HOT 0 //resident pages referenced often, in clock order
+#define CLOCK_PRO_COLD 1 //resident pages in their test period, in clock order
+#define CLOCK_PRO_TEST 2 //ghosts of cold pages evicted in their test period, oldest first
+
+class ClockProPager : public HistoryPager {
+	/*
+		Class Name: ClockProPager
+		Description: defines a class for pager allocating as per CLOCK-Pro (Jiang, Chen and 		Zhang). The cold hand evicts unreferenced cold pages, remembering them as ghosts, and 		turns referenced ones hot. The hot hand turns unreferenced hot pages cold so that at 		most frame_limit-cold_target pages are hot, and ends the test period of ghosts it 		passes. A fault on a ghost makes the page hot and grows cold_target, a ghost whose 		test period ends shrinks it.
+		The pages every hand acts on are kept in a list of their own, in the order the hand 		meets them in the clock, so hands never step over pages of other types. Ghosts carry 		the clock position of their page, the hot hand passes the ones behind the page it 		turns. Referenced bits are kept by the pager, so a hit is a single store.
+	*/
+private:
+	std::vector<unsigned long int> position; //clock position of every node, larger is later
+	std::vector<char> referenced; //referenced bit of every frame
+	unsigned long int clock_end; //position behind all nodes, where new nodes are put
+	int count_hot, count_cold, count_test; //number of nodes of every type
+	int cold_target; //target number of cold pages, between 1 and frame_limit
+	bool fault_hot; //whether the page of last fault was a ghost
+
+	void put(int type, int node) {
+		/*
+			Function Name: put
+			Arguments:
+				int type: list of node
+				int node: node put behind all others in the clock
+			Returns: void
+		*/
+		lists.push_back(type, node);
+		position[node] = clock_end++;
+	}
+
+	void forget_ghost(int g) {
+		/*
+			Function Name: forget_ghost
+			Arguments:
+				int g: ghost node
+			Returns: void
+			Description: ends the test period of an evicted page, cold pages were kept too long
+		*/
+		drop_ghost(g);
+		count_test--;
+		if(cold_target > 1) cold_target--;
+	}
+
+	void run_hand_hot() {
+		/*
+			Function Name: run_hand_hot
+			Returns: void
+			Description: moves the hot hand over the next hot page, turning it cold if it was 			not referenced, and ends the test period of ghosts passed on the way
+		*/
+		int node = lists.front(CLOCK_PRO_HOT);
+		unsigned long int passed = position[node];
+		lists.remove(node);
+		if(referenced[node]) {
+			referenced[node] = 0;
+			put(CLOCK_PRO_HOT, node);
+		} else {
+			put(CLOCK_PRO_COLD, node);
+			count_hot--;
+			count_cold++;
 		}
+		while(count_test > 0 && position[lists.front(CLOCK_PRO_TEST)] < passed) {
+			forget_ghost(lists.front(CLOCK_PRO_TEST));
+		}
+	}
+
+	void balance() {
+		while(count_hot > frame_limit - cold_target) run_hand_hot();
+	}
 
-		int min_age_ind = 0;
-		int min_age = age.at(0);
+public:
+	//a ghost is added before the oldest one is forgotten, so one more ghost than frames
+	ClockProPager(Frame *frame_table, int frame_limit, RandomGenerator *random) : HistoryPager(frame_table, frame_limit, random, 3, frame_limit + 1), position(2*frame_limit + 1, 0), referenced(frame_limit, 0) {
+		clock_end = 0;
+		count_hot = count_cold = count_test = 0;
+		cold_target = frame_limit;
+		fault_hot = false;
+	}
+
+	void page_fault(int process_id, int page_number) {
+		/*
+			Function Name: page_fault
+			Arguments:
+				int process_id: process of the page that is not in memory
+				int page_number: page that is not in memory
+			Returns: void
+			Description: a page faulted during its test period is promoted and its ghost forgotten
+		*/
+		fault_key = key(process_id, page_number);
+		int g = find_ghost(fault_key);
+		fault_hot = (g != -1);
+		if(fault_hot) {
+			if(cold_target < frame_limit) cold_target++;
+			drop_ghost(g);
+			count_test--;
+		}
+	}
+
+	Frame* determine_victim_frame() {
+		/*
+			Function Name: determine_victim_frame
+			Returns: 
+				Frame*: reference to frame selected by algorithm
+			Description: runs the cold hand until it evicts a cold page
+		*/
+		PROFILE_SCOPE("ClockProPager::determine_victim_frame");
+		while(true) {
+			//all pages can be hot right after a fault on a ghost
+			if(count_cold == 0) {
+				run_hand_hot();
+				continue;
+			}
 
-		for(int i = 1; i < frame_limit; i++) {
-			if(age.at(i) < age.at(min_age_ind)) {
-				min_age_ind = i;
-				min_age = age.at(i);
+			int node = lists.front(CLOCK_PRO_COLD);
+			lists.remove(node);
+			count_cold--;
+			if(referenced[node]) {
+				referenced[node] = 0;
+				put(CLOCK_PRO_HOT, node);
+				count_hot++;
+				balance();
+				continue;
 			}
+
+			//evicted page is remembered at its clock position
+			int g = add_ghost(frame_key(&frame_table[node]));
+			lists.push_back(CLOCK_PRO_TEST, g);
+			position[g] = position[node];
+			count_test++;
+			if(count_test > frame_limit) forget_ghost(lists.front(CLOCK_PRO_TEST));
+			balance();
+			return &frame_table[node];
+		}
+	}
+
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		int f = frame->frame_number;
+		if(lists.list_of(f) != -1) {
+			referenced[f] = 1;
+			return;
+		}
+
+		//page was just loaded
+		referenced[f] = 0;
+		if(fault_hot) {
+			put(CLOCK_PRO_HOT, f);
+			count_hot++;
+		} else {
+			put(CLOCK_PRO_COLD, f);
+			count_cold++;
 		}
+		fault_hot = false;
+	}
+
+	void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed
+			Returns: void
+			Description: takes the frame out of the clock without a ghost
+		*/
+		int f = frame->frame_number;
+		int l = lists.list_of(f);
+		if(l == -1) return;
+		lists.remove(f);
+		if(l == CLOCK_PRO_HOT) count_hot--;
+		else count_cold--;
+		referenced[f] = 0;
+	}
 
-		return frame_table[min_age_ind];
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+		*/
+		HistoryPager::state(snapshot);
+		snapshot.field(position);
+		snapshot.field(referenced);
+		snapshot.field(clock_end);
+		snapshot.field(count_hot);
+		snapshot.field(count_cold);
+		snapshot.field(count_test);
+		snapshot.field(cold_target);
+		snapshot.field(fault_hot);
 	}
 };
 
+#endif
+
+
+#ifndef OPT_PAGER_H
+#define OPT_PAGER_H
+
+class OPTPager : public Pager {
+	/*
+		Class Name: OPTPager
+		Description: defines a class for pager allocating as per Belady's MIN. The next use 		of every reference is computed by a pass over input file before simulation, victim is 		the frame whose page is used again last (lowest frame number among pages not used 		again). Frames are kept in a binary heap on next use of their page, so a reference 		and a fault are O(log frames).
+	*/
+private:
+	const std::vector<uint64_t> *next_use; //next use of every reference
+	uint64_t curr; //index of next reference
+	std::vector<uint64_t> key; //next use of page on every frame
+	std::vector<int> heap; //frames in memory, max heap on key
+	std::vector<int> heap_pos; //position of every frame in heap, -1 if not in it
+
+	bool above(int a, int b) {
+		return key[a] > key[b] || (key[a] == key[b] && a < b);
+	}
+
+	void swap_nodes(int i, int j) {
+		int t = heap[i];
+		heap[i] = heap[j];
+		heap[j] = t;
+		heap_pos[heap[i]] = i;
+		heap_pos[heap[j]] = j;
+	}
+
+	void sift_up(int i) {
+		while(i > 0 && above(heap[i], heap[(i - 1)/2])) {
+			swap_nodes(i, (i - 1)/2);
+			i = (i - 1)/2;
+		}
+	}
+
+	void sift_down(int i) {
+		int n = heap.size();
+		while(true) {
+			int top = i;
+			if(2*i + 1 < n && above(heap[2*i + 1], heap[top])) top = 2*i + 1;
+			if(2*i + 2 < n && above(heap[2*i + 2], heap[top])) top = 2*i + 2;
+			if(top == i) return;
+			swap_nodes(i, top);
+			i = top;
+		}
+	}
+
+public:
+	OPTPager(Frame *frame_table, int frame_limit, RandomGenerator *random, const std::vector<uint64_t> *next_use) : Pager(frame_table, frame_limit, random), key(frame_limit, NO_NEXT_USE), heap_pos(frame_limit, -1) {
+		/*
+			Function Name: constructor
+			Arguments:
+				Frame *frame_table: frame table of simulator
+				int frame_limit: number of frames in frame table
+				RandomGenerator *random: random numbers of simulator
+				const std::vector<uint64_t> *next_use: next use of every reference
+			Description: Initializes all the members of class
+		*/
+		this->next_use = next_use;
+		curr = 0;
+	}
+
+	Frame* determine_victim_frame() {
+		/*
+			Function Name: determine_victim_frame
+			Returns: 
+				Frame*: reference to frame selected by algorithm
+			Description: returns the frame whose page is used again last, it stays in heap 			and gets the key of the new page on its first reference
+		*/
+		PROFILE_SCOPE("OPTPager::determine_victim_frame");
+		return &frame_table[heap[0]];
+	}
 
-#endif
\ No newline at end of file
+	void reference_frame(Frame *frame) {
+		/*
+			Function Name: reference_frame
+			Arguments:
+				Frame *frame: frame whose page was just referenced
+			Returns: void
+		*/
+		int f = frame->frame_number;
+		key[f] = (curr < next_use->size()) ? (*next_use)[curr] : NO_NEXT_USE;
+		curr++;
+		if(heap_pos[f] == -1) {
+			heap.push_back(f);
+			heap_pos[f] = heap.size() - 1;
+		}
+		sift_up(heap_pos[f]);
+		sift_down(heap_pos[f]);
+	}
+
+	void release_frame(Frame *frame) {
+		/*
+			Function Name: release_frame
+			Arguments:
+				Frame *frame: frame whose page was freed
+			Returns: void
+			Description: takes the frame out of heap, the last node takes its place. Keys are 			ordered totally, so the shape of heap does not change the victims.
+		*/
+		int f = frame->frame_number;
+		int i = heap_pos[f];
+		if(i == -1) return;
+		swap_nodes(i, heap.size() - 1);
+		heap.pop_back();
+		heap_pos[f] = -1;
+		key[f] = NO_NEXT_USE;
+		if(i < (int)heap.size()) {
+			sift_up(i);
+			sift_down(i);
+		}
+	}
+
+	void state(Snapshot &snapshot) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+			Returns: void
+			Description: the next uses are not saved, they are computed from 			input file again
+		*/
+		snapshot.field(curr);
+		snapshot.field(key);
+		snapshot.field(heap);
+		snapshot.field(heap_pos);
+	}
+};
+
+#endif
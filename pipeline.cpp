@@ -0,0 +1,102 @@
+/*
+	Module Name: pipeline.cpp
+	Description: Runs a single simulation as a pipeline of three threads. The decode stage 		reads and decodes input file, the simulation stage updates the state of the 		simulation and emits a TraceEvent for every line of O output, the format stage renders 		them as text. The stages are connected by SpscRings, so each one works on the next 		batch while the following stage is busy with the previous one. Output is the same as 		that of simulate().
+*/
+#include <stdio.h>
+#include <thread>
+#include "simulator.h"
+
+
+void decode_stage(InputFile *input, SpscRing<Command> *commands) {
+	/*
+		Function Name: decode_stage
+		Arguments:
+			InputFile *input: input file being simulated
+			SpscRing<Command> *commands: ring decoded commands are pushed to
+		Returns: void
+		Description: body of decode thread, pushes all commands of input file in batches
+	*/
+	Command batch[PIPELINE_BATCH_SIZE];
+	while(true) {
+		int count = 0;
+		while(count < PIPELINE_BATCH_SIZE && input->getNextCommand(&batch[count])) count++;
+		if(count == 0) break;
+		commands->push(batch, count);
+	}
+	commands->close();
+}
+
+
+void format_stage(SpscRing<TraceEvent> *events, OutputBuffer *out) {
+	/*
+		Function Name: format_stage
+		Arguments:
+			SpscRing<TraceEvent> *events: ring trace events are popped from
+			OutputBuffer *out: output of simulation, not touched by simulation stage meanwhile
+		Returns: void
+		Description: body of format thread, renders all trace events
+	*/
+	TraceEvent *batch = new TraceEvent[PIPELINE_BATCH_SIZE];
+	int count;
+	while((count = events->pop(batch, PIPELINE_BATCH_SIZE)) > 0) {
+		PROFILE_SCOPE("format_stage");
+		for(int i = 0; i < count; i++) {
+			format_event(*out, batch[i]);
+		}
+	}
+	delete[] batch;
+}
+
+
+void Simulator::push_events() {
+	/*
+		Function Name: push_events
+		Returns: void
+		Description: hands the trace events emitted so far to the format stage
+	*/
+	if(event_count == 0) return;
+	event_ring->push(event_batch, event_count);
+	event_count = 0;
+}
+
+
+void Simulator::simulate_pipelined(InputFile *input, int num_stages) {
+	/*
+		Function Name: simulate_pipelined
+		Arguments:
+			InputFile *input: input file the simulator was created for
+			int num_stages: 2 for decode and simulation threads, 3 for a format thread too
+		Returns: void
+		Description: simulates all commands of input file like simulate(). Only O output is 		left to the format stage, x and f output is formatted by the simulation stage, so 		there is no format stage with them. Snapshots are not taken.
+	*/
+	SpscRing<Command> *commands = new SpscRing<Command>();
+	std::thread decoder(decode_stage, input, commands);
+
+	std::thread formatter;
+	if(num_stages >= 3 && O_flag && !x_flag && !f_flag) {
+		event_ring = new SpscRing<TraceEvent>();
+		event_batch = new TraceEvent[PIPELINE_BATCH_SIZE];
+		formatter = std::thread(format_stage, event_ring, &out);
+	}
+
+	Command *batch = new Command[PIPELINE_BATCH_SIZE];
+	int count;
+	while((count = commands->pop(batch, PIPELINE_BATCH_SIZE)) > 0) {
+		simulate_commands(batch, count);
+		if(event_ring != NULL) push_events();
+	}
+	decoder.join();
+	delete[] batch;
+	delete commands;
+
+	//summary is formatted once all O output is
+	if(event_ring != NULL) {
+		event_ring->close();
+		formatter.join();
+		delete event_ring;
+		delete[] event_batch;
+		event_ring = NULL;
+		event_batch = NULL;
+	}
+	print_summary();
+}
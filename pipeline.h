@@ -0,0 +1,234 @@
+/*
+	Module Name: pipeline.h
+	Description: Defines the parts of the pipelined simulation: SpscRing, a lock-free ring 		between one producer and one consumer thread, and TraceEvent, the compact record of one 		line of O output. The decode stage pushes commands into one ring, the simulation 		stage pushes trace events into another and the format stage renders them as text. 		The stages are run by Simulator::simulate_pipelined() in pipeline.cpp.
+*/
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include "output.h"
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#define PIPELINE_RING_SIZE (1 << 16) //items of a ring, a power of 2
+#define PIPELINE_BATCH_SIZE 4096 //items moved through a ring at once
+#define PIPELINE_SPINS 128 //polls of an empty or full ring before the thread yields
+
+//kinds of trace events, one per line of O output
+#define TRACE_COMMAND 0 //"<instr>: ==> <cmd> <num>"
+#define TRACE_UNMAP 1 //" UNMAP <num>:<arg>"
+#define TRACE_OUT 2
+#define TRACE_FOUT 3
+#define TRACE_FIN 4
+#define TRACE_IN 5
+#define TRACE_ZERO 6
+#define TRACE_MAP 7 //" MAP <num>"
+#define TRACE_SEGV 8
+#define TRACE_SEGPROT 9
+#define TRACE_COW 10
+#define TRACE_PROMOTE 11 //" PROMOTE <num>:<arg>"
+#define TRACE_DEMOTE 12 //" DEMOTE <num>:<arg>"
+#define TRACE_KSWAPD 13
+
+struct TraceEvent {
+	/*
+		Struct Name: TraceEvent
+		Description: defines one line of O output as emitted by simulate_command()
+	*/
+	char kind; //TRACE_*
+	char cmd; //command of TRACE_COMMAND
+	int32_t num; //argument of command, frame of MAP, process of UNMAP
+	uint64_t arg; //instruction number of command, page of UNMAP
+};
+
+static inline void format_event(OutputBuffer &out, const TraceEvent &event) {
+	/*
+		Function Name: format_event
+		Arguments:
+			OutputBuffer &out: output the line is appended to
+			const TraceEvent &event: event to be rendered
+		Returns: void
+		Description: renders the line of O output of an event
+	*/
+	switch(event.kind) {
+	case TRACE_COMMAND:
+		out.put_uint(event.arg);
+		out.put(": ==> ");
+		out.put(event.cmd);
+		out.put(' ');
+		out.put_int(event.num);
+		out.put('\n');
+		break;
+	case TRACE_UNMAP:
+		out.put(" UNMAP ");
+		out.put_int(event.num);
+		out.put(':');
+		out.put_uint(event.arg);
+		out.put('\n');
+		break;
+	case TRACE_OUT:
+		out.put(" OUT\n");
+		break;
+	case TRACE_FOUT:
+		out.put(" FOUT\n");
+		break;
+	case TRACE_FIN:
+		out.put(" FIN\n");
+		break;
+	case TRACE_IN:
+		out.put(" IN\n");
+		break;
+	case TRACE_ZERO:
+		out.put(" ZERO\n");
+		break;
+	case TRACE_MAP:
+		out.put(" MAP ");
+		out.put_int(event.num);
+		out.put('\n');
+		break;
+	case TRACE_SEGV:
+		out.put(" SEGV\n");
+		break;
+	case TRACE_SEGPROT:
+		out.put(" SEGPROT\n");
+		break;
+	case TRACE_COW:
+		out.put(" COW\n");
+		break;
+	case TRACE_PROMOTE:
+		out.put(" PROMOTE ");
+		out.put_int(event.num);
+		out.put(':');
+		out.put_uint(event.arg);
+		out.put('\n');
+		break;
+	case TRACE_DEMOTE:
+		out.put(" DEMOTE ");
+		out.put_int(event.num);
+		out.put(':');
+		out.put_uint(event.arg);
+		out.put('\n');
+		break;
+	case TRACE_KSWAPD:
+		out.put(" KSWAPD\n");
+		break;
+	}
+}
+
+static inline void ring_backoff(int &spins) {
+	/*
+		Function Name: ring_backoff
+		Arguments:
+			int &spins: polls so far, reset by caller once the ring moves
+		Returns: void
+		Description: waits a little before the ring is polled again. After PIPELINE_SPINS 		polls the thread yields, so a stage waiting on a slower one leaves it the core.
+	*/
+	if(++spins < PIPELINE_SPINS) return;
+	spins = 0;
+	std::this_thread::yield();
+}
+
+template <class T>
+class SpscRing {
+	/*
+		Class Name: SpscRing
+		Description: ring of PIPELINE_RING_SIZE items from one producer thread to one consumer 		thread. head and tail only grow and are written by one side each, on their own cache 		lines. Each side keeps a copy of the other's index and only reloads it when the 		ring looks full or empty. A full ring makes the producer wait, so the slowest stage 		sets the pace of the pipeline.
+	*/
+private:
+	T *items; //storage of ring
+	char pad0[64];
+	std::atomic<uint64_t> head; //next item to be popped, written by consumer
+	uint64_t tail_seen; //tail as last seen by consumer
+	char pad1[64];
+	std::atomic<uint64_t> tail; //next free slot, written by producer
+	uint64_t head_seen; //head as last seen by producer
+	char pad2[64];
+	std::atomic<bool> closed; //whether producer is done, set after its last push
+
+public:
+	SpscRing() : head(0), tail(0), closed(false) {
+		items = new T[PIPELINE_RING_SIZE];
+		tail_seen = head_seen = 0;
+	}
+
+	~SpscRing() {
+		delete[] items;
+	}
+
+	void push(const T *values, int count) {
+		/*
+			Function Name: push
+			Arguments:
+				const T *values: items to be appended
+				int count: number of items
+			Returns: void
+			Description: appends all items, waiting for room while the ring is full. Items 			are published whenever a contiguous part of them is copied.
+		*/
+		uint64_t t = tail.load(std::memory_order_relaxed);
+		int spins = 0;
+		while(count > 0) {
+			uint64_t room = PIPELINE_RING_SIZE - (t - head_seen);
+			if(room == 0) {
+				head_seen = head.load(std::memory_order_acquire);
+				if(t - head_seen == PIPELINE_RING_SIZE) ring_backoff(spins);
+				continue;
+			}
+			uint64_t start = t & (PIPELINE_RING_SIZE - 1);
+			uint64_t n = count;
+			if(n > room) n = room;
+			if(n > PIPELINE_RING_SIZE - start) n = PIPELINE_RING_SIZE - start;
+			for(uint64_t i = 0; i < n; i++) {
+				items[start + i] = values[i];
+			}
+			t += n;
+			values += n;
+			count -= n;
+			tail.store(t, std::memory_order_release);
+			spins = 0;
+		}
+	}
+
+	int pop(T *values, int max) {
+		/*
+			Function Name: pop
+			Arguments:
+				T *values: filled with the oldest items
+				int max: largest number of items to be taken
+			Returns: int - number of items taken, 0 once the producer is done and the ring 			is empty
+			Description: waits until there is at least one item
+		*/
+		uint64_t h = head.load(std::memory_order_relaxed);
+		int spins = 0;
+		while(tail_seen == h) {
+			tail_seen = tail.load(std::memory_order_acquire);
+			if(tail_seen != h) break;
+			if(closed.load(std::memory_order_acquire)) {
+				//the last items may have been pushed right before closing
+				tail_seen = tail.load(std::memory_order_acquire);
+				if(tail_seen == h) return 0;
+				break;
+			}
+			ring_backoff(spins);
+		}
+		uint64_t start = h & (PIPELINE_RING_SIZE - 1);
+		uint64_t n = tail_seen - h;
+		if(n > (uint64_t)max) n = max;
+		if(n > PIPELINE_RING_SIZE - start) n = PIPELINE_RING_SIZE - start;
+		for(uint64_t i = 0; i < n; i++) {
+			values[i] = items[start + i];
+		}
+		head.store(h + n, std::memory_order_release);
+		return n;
+	}
+
+	void close() {
+		/*
+			Function Name: close
+			Returns: void
+			Description: called by producer after its last push
+		*/
+		closed.store(true, std::memory_order_release);
+	}
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*
+	Module Name: profile.cpp
+	Description: Keeps the list of profiled blocks and prints their breakdown table at exit. 		With --perf-counters every thread opens a group of perf_event_open counters for itself, 		counters the kernel or container does not allow are left out. Empty unless MMU_PROFILE 		is defined.
+*/
+#ifdef MMU_PROFILE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include "profile.h"
+
+
+struct ProfileEvent {
+	/*
+		Struct Name: ProfileEvent
+		Description: defines one counter of perf_event_open
+	*/
+	const char *name; //column of counter in tables
+	uint32_t type; //type of perf_event_attr
+	uint64_t config; //config of perf_event_attr
+};
+
+static const ProfileEvent profile_event_list[PROFILE_EVENTS] = {
+	{"task-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+	{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{"L1D-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+	{"LLC-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+
+/**************************** Global Variables ****************************/
+ProfileCounter *profile_counters = NULL; //list of all counters used so far
+std::mutex profile_lock; //guards profile_counters
+bool profile_events_enabled = false; //whether counters are read around every block
+bool profile_event_available[PROFILE_EVENTS]; //whether counter could be opened by main thread
+std::atomic<uint64_t> profile_references(0); //references of all simulations
+std::atomic<uint64_t> profile_faults(0); //page faults of all simulations
+std::atomic<uint64_t> profile_time_enabled(0); //nanoseconds counter groups were open
+std::atomic<uint64_t> profile_time_running(0); //nanoseconds counter groups were counting
+
+
+class ProfileEventGroup {
+	/*
+		Class Name: ProfileEventGroup
+		Description: the counters of one thread, opened as a group so they are read together 		by one read(2) and are always scheduled together. Only user space is counted, so the 		reads themselves hardly show up. Closed when the thread exits.
+	*/
+private:
+	int fds[PROFILE_EVENTS]; //file descriptor of every counter, -1 if not open
+	int slot[PROFILE_EVENTS]; //position of every counter in group, -1 if not open
+	int leader; //file descriptor of group leader, -1 if no counter is open
+	int members; //number of open counters
+	bool opened; //whether opening was tried
+	uint64_t time_enabled, time_running; //times of group at last read
+
+public:
+	ProfileEventGroup() {
+		for(int i = 0; i < PROFILE_EVENTS; i++) {
+			fds[i] = slot[i] = -1;
+		}
+		leader = -1;
+		members = 0;
+		opened = false;
+		time_enabled = time_running = 0;
+	}
+
+	~ProfileEventGroup() {
+		profile_time_enabled.fetch_add(time_enabled);
+		profile_time_running.fetch_add(time_running);
+		for(int i = PROFILE_EVENTS - 1; i >= 0; i--) {
+			if(fds[i] >= 0) close(fds[i]);
+		}
+		leader = -1;
+	}
+
+	void open(bool probe) {
+		/*
+			Function Name: open
+			Arguments:
+				bool probe: whether all counters are tried and their availability noted, 				otherwise only those available to main thread are opened
+			Returns: void
+		*/
+		opened = true;
+		for(int i = 0; i < PROFILE_EVENTS; i++) {
+			if(!probe && !profile_event_available[i]) continue;
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = profile_event_list[i].type;
+			attr.config = profile_event_list[i].config;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+			if(probe) {
+				profile_event_available[i] = (fd >= 0);
+				if(fd < 0) fprintf(stderr, "perf counter %s unavailable: %s\n", profile_event_list[i].name, strerror(errno));
+			}
+			if(fd < 0) continue;
+			if(leader == -1) leader = fd;
+			fds[i] = fd;
+			slot[i] = members++;
+		}
+	}
+
+	bool read_values(uint64_t *values) {
+		/*
+			Function Name: read_values
+			Arguments:
+				uint64_t *values: set to current value of every counter, 0 for those not open
+			Returns: bool - false if no counter is open
+		*/
+		if(!opened) open(false);
+		if(leader == -1) return false;
+		uint64_t data[3 + PROFILE_EVENTS]; //number of counters, times, values
+		ssize_t size = (3 + members)*sizeof(uint64_t);
+		if(read(leader, data, size) != size) return false;
+		time_enabled = data[1];
+		time_running = data[2];
+		for(int i = 0; i < PROFILE_EVENTS; i++) {
+			values[i] = (slot[i] >= 0) ? data[3 + slot[i]] : 0;
+		}
+		return true;
+	}
+};
+
+
+ProfileEventGroup& thread_event_group() {
+	/*
+		Function Name: thread_event_group
+		Returns: ProfileEventGroup& - counters of calling thread
+	*/
+	thread_local ProfileEventGroup group;
+	return group;
+}
+
+
+bool profile_enable_events() {
+	/*
+		Function Name: profile_enable_events
+		Returns: bool - true, the profiler is built in
+		Description: opens the counters of main thread and notes which ones are available, 		so worker threads do not try the others again. If none is, e.g. in a container 		without access to perf_event_open, only cycles are profiled.
+	*/
+	thread_event_group().open(true);
+	for(int i = 0; i < PROFILE_EVENTS; i++) {
+		if(profile_event_available[i]) profile_events_enabled = true;
+	}
+	if(!profile_events_enabled) fprintf(stderr, "no perf counters available, profiling cycles only\n");
+	return true;
+}
+
+
+bool profile_read_events(uint64_t *values) {
+	/*
+		Function Name: profile_read_events
+		Arguments:
+			uint64_t *values: set to current value of every counter of calling thread
+		Returns: bool - false if the thread has no counters
+	*/
+	return thread_event_group().read_values(values);
+}
+
+
+void profile_add_work(uint64_t references, uint64_t faults) {
+	/*
+		Function Name: profile_add_work
+		Arguments:
+			uint64_t references: references simulated by a simulation
+			uint64_t faults: page faults of a simulation
+		Returns: void
+		Description: counters are reported per reference and per fault of all simulations
+	*/
+	profile_references.fetch_add(references);
+	profile_faults.fetch_add(faults);
+}
+
+
+ProfileCounter::ProfileCounter(const char *name) : calls(0), cycles(0) {
+	/*
+		Function Name: constructor
+		Arguments:
+			const char *name: block as printed in table
+		Description: adds the counter to the list of all counters
+	*/
+	this->name = name;
+	for(int i = 0; i < PROFILE_EVENTS; i++) {
+		events[i] = 0;
+	}
+	std::lock_guard<std::mutex> guard(profile_lock);
+	next = profile_counters;
+	profile_counters = this;
+}
+
+
+bool more_cycles(ProfileCounter *a, ProfileCounter *b) {
+	return a->cycles.load() > b->cycles.load();
+}
+
+
+class ProfileReport {
+	/*
+		Class Name: ProfileReport
+		Description: notes the start of program and prints the table when it is destroyed at 		exit. Blocks nest, so their shares of the run add up to more than 100%.
+	*/
+private:
+	uint64_t start; //clock at start of program
+
+public:
+	ProfileReport() {
+		start = profile_clock();
+	}
+
+	~ProfileReport() {
+		uint64_t total = profile_clock() - start;
+		std::vector<ProfileCounter*> counters;
+		for(ProfileCounter *counter = profile_counters; counter != NULL; counter = counter->next) {
+			counters.push_back(counter);
+		}
+		std::sort(counters.begin(), counters.end(), more_cycles);
+
+		fprintf(stderr, "%-44s %14s %18s %12s %7s\n", "block", "calls", "cycles", "cycles/call", "run");
+		for(int i = 0; i < (int)counters.size(); i++) {
+			uint64_t calls = counters[i]->calls.load();
+			uint64_t cycles = counters[i]->cycles.load();
+			fprintf(stderr, "%-44s %14llu %18llu %12.1f %6.2f%%\n", counters[i]->name, (unsigned long long)calls, (unsigned long long)cycles, calls ? (double)cycles/calls : 0.0, total ? 100.0*cycles/total : 0.0);
+		}
+		fprintf(stderr, "%-44s %14s %18llu\n", "whole run", "", (unsigned long long)total);
+		if(profile_events_enabled) {
+			print_events(counters, "reference", profile_references.load());
+			print_events(counters, "page fault", profile_faults.load());
+			uint64_t enabled = profile_time_enabled.load(), running = profile_time_running.load();
+			if(running < enabled) fprintf(stderr, "counters were only scheduled %.1f%% of the time, counts are too low\n", 100.0*running/enabled);
+		}
+	}
+
+	void print_events(std::vector<ProfileCounter*> &counters, const char *unit, uint64_t units) {
+		/*
+			Function Name: print_events
+			Arguments:
+				std::vector<ProfileCounter*> &counters: all blocks, in order of table
+				const char *unit: what counters are normalized by
+				uint64_t units: number of references or faults of all simulations
+			Returns: void
+			Description: prints the counters of every block divided by units, along with 			instructions per cycle
+		*/
+		fprintf(stderr, "\nper %s (%llu)\n%-44s", unit, (unsigned long long)units, "block");
+		for(int e = 0; e < PROFILE_EVENTS; e++) {
+			if(profile_event_available[e]) fprintf(stderr, " %14s", profile_event_list[e].name);
+		}
+		fprintf(stderr, " %7s\n", "IPC");
+		for(int i = 0; i < (int)counters.size(); i++) {
+			if(counters[i]->calls.load() == 0) continue;
+			fprintf(stderr, "%-44s", counters[i]->name);
+			for(int e = 0; e < PROFILE_EVENTS; e++) {
+				if(profile_event_available[e]) fprintf(stderr, " %14.2f", units ? (double)counters[i]->events[e].load()/units : 0.0);
+			}
+			uint64_t cycles = counters[i]->events[1].load(), instructions = counters[i]->events[2].load();
+			if(cycles > 0) fprintf(stderr, " %7.2f\n", (double)instructions/cycles);
+			else fprintf(stderr, " %7s\n", "n/a");
+		}
+	}
+};
+
+ProfileReport profile_report; //prints the table at exit
+
+#endif
@@ -0,0 +1,99 @@
+/*
+	Module Name: profile.h
+	Description: Defines the built-in profiler. PROFILE_SCOPE(name) counts the calls of the 		enclosing block and the cycles spent in it, a breakdown table of all blocks is printed to 		stderr at exit. With --perf-counters the hardware counters of perf_event_open are read 		around every block as well and reported per simulated reference and per page fault. 		The profiler only exists in builds with MMU_PROFILE defined (make mmu_profile), 		otherwise PROFILE_SCOPE expands to nothing.
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#ifdef MMU_PROFILE
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define PROFILE_EVENTS 6 //counters of perf_event_open: task clock, cycles, instructions, L1D, LLC and branch misses
+
+struct ProfileCounter {
+	/*
+		Struct Name: ProfileCounter
+		Description: defines the counts of one profiled block. Counters are static, they add 		themselves to a list on first use and are never destroyed, so they are still there 		when the table is printed at exit.
+	*/
+	const char *name; //block as printed in table
+	std::atomic<uint64_t> calls; //times the block was entered
+	std::atomic<uint64_t> cycles; //cycles spent in the block, including nested blocks
+	std::atomic<uint64_t> events[PROFILE_EVENTS]; //counter values spent in the block, with --perf-counters
+	ProfileCounter *next; //next counter in list of all counters
+
+	ProfileCounter(const char *name);
+};
+
+extern bool profile_events_enabled; //whether counters are read around every block
+bool profile_enable_events();
+bool profile_read_events(uint64_t *values);
+void profile_add_work(uint64_t references, uint64_t faults);
+
+static inline uint64_t profile_clock() {
+	/*
+		Function Name: profile_clock
+		Returns: uint64_t - time stamp counter, or nanoseconds where there is none
+	*/
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+#endif
+}
+
+class ProfileTimer {
+	/*
+		Class Name: ProfileTimer
+		Description: adds the cycles from its construction to its destruction to a counter. 		Counters of perf_event_open are read outside of the timed part of the block, but 		inside that of enclosing blocks, whose cycles then include the reads.
+	*/
+private:
+	ProfileCounter *counter;
+	uint64_t start;
+	bool events; //whether start_events were read
+	uint64_t start_events[PROFILE_EVENTS];
+
+public:
+	ProfileTimer(ProfileCounter *counter) {
+		this->counter = counter;
+		events = profile_events_enabled && profile_read_events(start_events);
+		start = profile_clock();
+	}
+
+	~ProfileTimer() {
+		counter->cycles.fetch_add(profile_clock() - start, std::memory_order_relaxed);
+		counter->calls.fetch_add(1, std::memory_order_relaxed);
+		uint64_t end_events[PROFILE_EVENTS];
+		if(events && profile_read_events(end_events)) {
+			for(int i = 0; i < PROFILE_EVENTS; i++) {
+				counter->events[i].fetch_add(end_events[i] - start_events[i], std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+#define PROFILE_JOIN(a, b) a##b
+#define PROFILE_NAME(a, line) PROFILE_JOIN(a, line)
+#define PROFILE_SCOPE(name) \
+	static ProfileCounter PROFILE_NAME(profile_counter_, __LINE__)(name); \
+	ProfileTimer PROFILE_NAME(profile_timer_, __LINE__)(&PROFILE_NAME(profile_counter_, __LINE__))
+#define PROFILE_WORK(references, faults) profile_add_work(references, faults)
+#define PROFILE_ENABLE_EVENTS() profile_enable_events()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_WORK(references, faults)
+#define PROFILE_ENABLE_EVENTS() false
+
+#endif
+
+#endif
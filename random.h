@@ -0,0 +1,49 @@
+/*
+	Module Name: random.h
+	Description: Defines RandomTable and RandomGenerator. Random numbers of an rfile are loaded 		once by random.cpp into a RandomTable and shared read-only, every generator keeps its own 		position in them.
+*/
+
+#include <stddef.h>
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+struct RandomTable {
+	/*
+		Struct Name: RandomTable
+		Description: defines the random numbers of one rfile
+	*/
+	int *numbers; //array that holds the numbers
+	int size; //number of random numbers in rfile
+};
+
+class RandomGenerator {
+	/*
+		Class Name: RandomGenerator
+		Description: generates random numbers from a table starting at its first number
+	*/
+public:
+	const RandomTable *table; //random numbers, shared with other generators
+	int curr; //current position in array
+
+	RandomGenerator(const RandomTable *table = NULL) {
+		this->table = table;
+		curr = 0;
+	}
+
+	int myrandom(int size) {
+		/*
+			Function Name: myrandom
+			Arguments:
+				int size: size to be taken as modulus
+			Returns: int - random number
+			Description: takes random number from array and generates the number using size.
+		*/
+		int num = table->numbers[curr];
+		num = num % size;
+		curr = (curr + 1) % table->size;
+		return num;
+	}
+};
+
+#endif
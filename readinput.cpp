@@ -1,144 +1,411 @@
 /*
 	Module Name: readinput.cpp
-	Description: designed to read input file and initialize process page tables and its VMAs. Also it reads input commands one by one and gives it to simulator.
+	Description: designed to read input file and initialize process page tables and its VMAs. Also it reads input commands one by one and gives it to simulator. Text input is streamed through a fixed size buffer filled with read(2), so memory use does not depend on the length of the input file.
 */
 
 #include <stdio.h>
-#include <fstream>
 #include <string.h>
-#include "datastructures.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdlib.h>
+#include "readinput.h"
 
-/**************************** Global Variables ****************************/
-std::fstream file; //reference to input file
 
+InputFile::InputFile(int vpage_bits) {
+	/*
+		Function Name: constructor
+		Arguments:
+			int vpage_bits: width of virtual address space in pages
+		Description: allocates the buffers, no file is opened yet
+	*/
+	input_fd = -1;
+	read_buffer = (char*)malloc(READ_BUFFER_SIZE);
+	read_pos = read_end = read_buffer;
+	read_eof = false;
+	read_offset = 0;
+	commands_offset = 0;
+	last_command_num = 0;
+
+	binary_input = false;
+	trace_base = NULL;
+	trace_size = 0;
+	trace_commands = NULL;
+	trace_num_commands = 0;
+	trace_curr = 0;
+
+	command_buffer = (Command*)malloc(sizeof(Command)*COMMAND_BUFFER_SIZE);
+	command_count = command_pos = 0;
+
+	processes = NULL;
+	num_processes = 0;
+	this->vpage_bits = vpage_bits;
+	next_uses = NULL;
+	file_size = 0;
+	file_mtime = 0;
+}
 
-/*************************** imported from main.cpp ***************************/
-extern Process **processes; //contains objects of all processes
-extern int num_processes; //total number of processes
 
-void openInputFile(char *filename) {
+InputFile::~InputFile() {
+	if(input_fd >= 0) close(input_fd);
+	if(trace_base != NULL) munmap((void*)trace_base, trace_size);
+	for(int i = 0; i < num_processes; i++) {
+		delete processes[i];
+	}
+	free(processes);
+	delete next_uses;
+	free(read_buffer);
+	free(command_buffer);
+}
+
+
+void InputFile::openInputFile(char *filename) {
 	/*
 		Function Name: openInputFile
 		Arguments:
 			char *filename: path to input file
 		Returns: void
-		Description: initializes reference to input file in input mode
+		Description: initializes reference to input file in input mode. If the file is a 		binary trace then it is memory mapped instead.
 	*/
+	struct stat st;
+	if(stat(filename, &st) != 0) {
+		perror(filename);
+		exit(1);
+	}
+	file_size = st.st_size;
+	file_mtime = (int64_t)st.st_mtim.tv_sec*1000000000 + st.st_mtim.tv_nsec;
+
+	//binary traces are recognised by their magic number
+	binary_input = openBinaryTrace(filename);
+	if(binary_input) return;
 
-	//open file in std::ios_base::in mode to read from file.
-	file.open(filename, std::ios_base::in);
+	if(input_fd >= 0) close(input_fd);
+	input_fd = open(filename, O_RDONLY);
+	if(input_fd < 0) {
+		perror(filename);
+		exit(1);
+	}
+	read_pos = read_end = read_buffer;
+	read_eof = false;
+	read_offset = 0;
+	command_count = command_pos = 0;
 }
 
 
+bool InputFile::nextLine(char **line, char **line_end) {
+	/*
+		Function Name: nextLine
+		Arguments:
+			char **line: set to the first character of next line
+			char **line_end: set to one past the last character of next line
+		Returns: bool - false if input file is exhausted, true otherwise
+		Description: returns the next line of input file without copying it. The buffer is 		refilled when the line is not completely inside it.
+	*/
+	while(true) {
+		char *newline = (char*)memchr(read_pos, '\n', read_end - read_pos);
+		if(newline != NULL) {
+			*line = read_pos;
+			*line_end = newline;
+			read_pos = newline + 1;
+			return true;
+		}
+
+		//last line of file without trailing newline
+		if(read_eof) {
+			if(read_pos == read_end) return false;
+			*line = read_pos;
+			*line_end = read_end;
+			read_pos = read_end;
+			return true;
+		}
+
+		//move the partial line to the front and fill the rest of the buffer
+		size_t pending = read_end - read_pos;
+		if(pending == READ_BUFFER_SIZE) {
+			//line longer than the buffer, hand it out in pieces
+			*line = read_pos;
+			*line_end = read_end;
+			read_pos = read_end;
+			return true;
+		}
+		memmove(read_buffer, read_pos, pending);
+		read_pos = read_buffer;
+		read_end = read_buffer + pending;
+		ssize_t got = read(input_fd, read_end, READ_BUFFER_SIZE - pending);
+		if(got <= 0) {
+			read_eof = true;
+		} else {
+			read_end += got;
+			read_offset += got;
+		}
+	}
+}
+
 
-void initProcess() {
+bool InputFile::nextInputLine(char **line, char **line_end) {
 	/*
-		Function Name: initProcess
+		Function Name: nextInputLine
+		Arguments:
+			char **line: set to the first character of next line
+			char **line_end: set to one past the last character of next line
+		Returns: bool - false if input file is exhausted, true otherwise
+		Description: returns the next line which is neither empty nor a comment
+	*/
+	while(nextLine(line, line_end)) {
+		if(*line == *line_end || **line == '#') continue;
+		return true;
+	}
+	return false;
+}
+
+
+bool parseInt(char **pos, char *end, int *value) {
+	/*
+		Function Name: parseInt
+		Arguments:
+			char **pos: position to parse from, moved past the parsed number
+			char *end: end of the line
+			int *value: set to parsed number, left untouched if there is none
+		Returns: bool - true if a number was parsed
+		Description: skips white space and parses a decimal integer, as sscanf %d does
+	*/
+	char *p = *pos;
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+
+	bool negative = false;
+	if(p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		p++;
+	}
+	if(p == end || *p < '0' || *p > '9') return false;
+
+	int num = 0;
+	while(p < end && *p >= '0' && *p <= '9') {
+		num = num*10 + (*p - '0');
+		p++;
+	}
+	*value = negative ? -num : num;
+	*pos = p;
+	return true;
+}
+
+
+void initPageTable(Process *process) {
+	/*
+		Function Name: initPageTable
+		Arguments:
+			Process *process: process whose page table is to be initialized from its VMAs
 		Returns: void
-		Description: initializes process page tables and its VMAs as specified in input file
+		Description: initializes the PTE of all VMA pages of process. Pages outside of VMAs 		are holes, they are left unpopulated and read as invalid.
 	*/
+	for(int k = 0; k < (int)process->vmas.size(); k++) {
+		VMA &vma = process->vmas[k];
 
-	int num_vmas, s_vma, e_vma, w_prot, f_wrt; //used to read from file
-	char line[100]; //buffer
+		//VMA must fit into virtual address space
+		if(vma.start_page < 0 || vma.end_page < vma.start_page || (unsigned int)vma.end_page >= process->page_table.size()) {
+			fprintf(stderr, "VMA %d-%d of process %d does not fit into %u pages, increase -v\n", vma.start_page, vma.end_page, process->process_id, process->page_table.size());
+			exit(1);
+		}
 
-	//skip until first input
-	file.getline(line, 100);
-	while(strlen(line) == 0 || line[0] == '#') {
-		if(file.getline(line, 100)) continue;
+		//initialize the current VMA PTE entries as specified
+		for(int j = vma.start_page; j <= vma.end_page; j++) {
+			PTE *pte = process->page_table.populate(j);
+			pte->valid = 1;
+			pte->write_protected = vma.write_protected;
+			pte->modified = 0;
+			pte->referenced = 0;
+			pte->paged_out = 0;
+			pte->file_mapped = vma.file_mapped;
+			pte->frame_assigned = 0;
+			pte->frame_index = 0;
+		}
 	}
+}
+
+
+void clearPageTable(Process *process) {
+	/*
+		Function Name: clearPageTable
+		Arguments:
+			Process *process: process whose VMAs are removed
+		Returns: void
+		Description: makes the PTEs of all VMA pages of process invalid and forgets its VMAs, 		as done by exec and exit. The pages must not be in memory any more.
+	*/
+	for(int k = 0; k < (int)process->vmas.size(); k++) {
+		for(int j = process->vmas[k].start_page; j <= process->vmas[k].end_page; j++) {
+			PTE *pte = process->page_table.lookup(j);
+			*pte = PTE();
+		}
+	}
+	process->vmas.clear();
+}
+
+
+void InputFile::initProcess() {
+	/*
+		Function Name: initProcess
+		Returns: void
+		Description: initializes processes and their VMAs as specified in input file. Page 		tables are initialized from the VMAs by each simulator.
+	*/
+
+	if(binary_input) {
+		initProcessBinary();
+		return;
+	}
+
+	int num_vmas = 0; //used to read from file
+	VMA vma; //used to read from file
+	char *line, *line_end; //current line
 
 	//read first line as number of processes
-	sscanf(line, "%d", &num_processes);
+	num_processes = 0;
+	if(nextInputLine(&line, &line_end)) parseInt(&line, line_end, &num_processes);
 	
-	//initialize list of all processes maintained globally in main.cpp
+	//initialize list of all processes
 	processes = (Process**)malloc(sizeof(Process*)*num_processes);
 
 
 	//initialize page table of all the processes as specified in input file
 	for(int i = 0; i < num_processes; i++) {
-		processes[i] = new Process(i);
+		processes[i] = new Process(i, vpage_bits);
 
-		//skip until next input line
-		file.getline(line, 100);
-		while(strlen(line) == 0 || line[0] == '#') {
-			if(file.getline(line, 100)) continue;
-		}
-		
 		//read the number of VMA for process i
-		sscanf(line, "%d", &num_vmas);
-		
-		int j = 0; //references to 1 position after the last initialized PTE
-
+		if(nextInputLine(&line, &line_end)) parseInt(&line, line_end, &num_vmas);
 
-		//read each VMA and initialize appropriately
+		//read each VMA specification
 		for(int k = 0; k < num_vmas; k++) {
-			//skip until next input line
-			file.getline(line, 100);
-			while(strlen(line) == 0 || line[0] == '#') {
-				if(file.getline(line, 100)) continue;
-			}
-
-			//read VMA specification
-			sscanf(line, "%d %d %d %d", &s_vma, &e_vma, &w_prot, &f_wrt);	
-
-			//set all PTE as invalid from j to s_vma. 
-			//This is to initialize the PTE of holes as invalid
-			while(j < s_vma) {
-				processes[i]->page_table[j]->valid = 0;
-				processes[i]->page_table[j]->write_protected = 0;
-				processes[i]->page_table[j]->modified = 0;
-				processes[i]->page_table[j]->referenced = 0;
-				processes[i]->page_table[j]->paged_out = 0;
-				processes[i]->page_table[j]->file_mapped = 0;
-				processes[i]->page_table[j]->frame_assigned = 0;
-				processes[i]->page_table[j]->frame_index = 0;
-				j++;
-			}
-
-			//next initialize the current VMA PTE entries as specified
-			while(j <= e_vma) {
-				processes[i]->page_table[j]->valid = 1;
-				processes[i]->page_table[j]->write_protected = w_prot;
-				processes[i]->page_table[j]->modified = 0;
-				processes[i]->page_table[j]->referenced = 0;
-				processes[i]->page_table[j]->paged_out = 0;
-				processes[i]->page_table[j]->file_mapped = f_wrt;
-				processes[i]->page_table[j]->frame_assigned = 0;
-				processes[i]->page_table[j]->frame_index = 0;
-				j++;
-			}
-		}
+			if(!nextInputLine(&line, &line_end)) break;
+			parseInt(&line, line_end, &vma.start_page);
+			parseInt(&line, line_end, &vma.end_page);
+			parseInt(&line, line_end, &vma.write_protected);
+			parseInt(&line, line_end, &vma.file_mapped);
 
-		//This is to take care of hole at the end of VMA if any.
-		while(j < 64) {
-			processes[i]->page_table[j]->valid = 0;
-				processes[i]->page_table[j]->write_protected = w_prot;
-				processes[i]->page_table[j]->modified = 0;
-				processes[i]->page_table[j]->referenced = 0;
-				processes[i]->page_table[j]->paged_out = 0;
-				processes[i]->page_table[j]->file_mapped = f_wrt;
-				processes[i]->page_table[j]->frame_assigned = 0;
-				processes[i]->page_table[j]->frame_index = 0;
-				j++;
+			//shared flag is optional, older input files have 4 fields
+			vma.shared = 0;
+			parseInt(&line, line_end, &vma.shared);
+			processes[i]->vmas.push_back(vma);
 		}
 	}
+
+	//remember where commands start so input can be replayed
+	commands_offset = read_offset - (read_end - read_pos);
 }
 
-char* getNextLine() {
+
+void InputFile::rewindInput() {
 	/*
-		Function Name: getNextLine
-		Returns: char* - input command string
-		Description: get the next command line from the file and return the same.
+		Function Name: rewindInput
+		Returns: void
+		Description: restarts the commands of input file from the first one, for analyses 		that need more than one pass
 	*/
-	char *line = new char[100]; //buffer to hold line
+	command_count = command_pos = 0;
+	last_command_num = 0;
+	if(binary_input) {
+		rewindBinaryTrace();
+		return;
+	}
+	lseek(input_fd, commands_offset, SEEK_SET);
+	read_offset = commands_offset;
+	read_pos = read_end = read_buffer;
+	read_eof = false;
+}
 
-	//get the next valid line
-	while(file.getline(line, 100)) {
-		if(strlen(line) == 0 || line[0] == '#') {
-			continue;
-		}
-		return line;
+
+int InputFile::getNextTextCommands(Command *commands, int max) {
+	/*
+		Function Name: getNextTextCommands
+		Arguments:
+			Command *commands: filled with the decoded commands
+			int max: maximum number of commands to be decoded
+		Returns: int - number of commands decoded, 0 if input file is exhausted
+		Description: decodes the next command lines of text input file
+	*/
+	char *line, *line_end;
+	int count = 0;
+	int num = last_command_num; //argument of previous command, kept when a line has none
+
+	while(count < max && nextInputLine(&line, &line_end)) {
+		commands[count].cmd = *line++;
+		parseInt(&line, line_end, &num);
+		commands[count].num = num;
+		count++;
+	}
+	last_command_num = num;
+	return count;
+}
+
+
+InputPosition InputFile::tellInput() {
+	/*
+		Function Name: tellInput
+		Returns: InputPosition - position of next command
+		Description: the position stays valid after the file is opened again by another 		InputFile, so a simulation can be continued from it
+	*/
+	if(command_pos < command_count) {
+		InputPosition position = batch_start;
+		position.skip = command_pos;
+		return position;
+	}
+	InputPosition position;
+	position.offset = binary_input ? trace_curr : read_offset - (read_end - read_pos);
+	position.last_command_num = last_command_num;
+	position.skip = 0;
+	return position;
+}
+
+
+bool InputFile::refillCommands() {
+	/*
+		Function Name: refillCommands
+		Returns: bool - false if there are no more commands, true otherwise
+		Description: decodes the next batch of commands into command_buffer
+	*/
+	PROFILE_SCOPE("InputFile::refillCommands");
+	batch_start = tellInput();
+	if(binary_input) {
+		command_count = getNextBinaryCommands(command_buffer, COMMAND_BUFFER_SIZE);
+	} else {
+		command_count = getNextTextCommands(command_buffer, COMMAND_BUFFER_SIZE);
 	}
-	return NULL;
-}
\ No newline at end of file
+	command_pos = 0;
+	return command_count != 0;
+}
+
+
+void InputFile::seekInput(InputPosition position) {
+	/*
+		Function Name: seekInput
+		Arguments:
+			InputPosition position: position returned by tellInput()
+		Returns: void
+		Description: continues the commands of input file from position. The batch holding 		the next command is decoded again and its commands before it are skipped.
+	*/
+	command_count = command_pos = 0;
+	last_command_num = position.last_command_num;
+	if(binary_input) {
+		trace_curr = (position.offset < trace_num_commands) ? position.offset : trace_num_commands;
+	} else {
+		lseek(input_fd, position.offset, SEEK_SET);
+		read_offset = position.offset;
+		read_pos = read_end = read_buffer;
+		read_eof = false;
+	}
+	if(position.skip > 0 && refillCommands()) {
+		command_pos = (position.skip < command_count) ? position.skip : command_count;
+	}
+}
+
+
+bool InputFile::getNextCommand(Command *command) {
+	/*
+		Function Name: getNextCommand
+		Arguments:
+			Command *command: filled with the next command
+		Returns: bool - false if there are no more commands, true otherwise
+		Description: get the next command from the input file, in whichever format it is. 		Commands are decoded in batches into a reusable buffer.
+	*/
+	if(command_pos == command_count && !refillCommands()) return false;
+	*command = command_buffer[command_pos++];
+	return true;
+}
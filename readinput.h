@@ -0,0 +1,84 @@
+/*
+	Module Name: readinput.h
+	Description: Defines InputFile, the reader of one input file. All reading state is kept 		per instance, so several input files can be read side by side. Text input is 		implemented in readinput.cpp and binary traces in binarytrace.cpp.
+*/
+#include <stdint.h>
+#include <sys/types.h>
+#include <vector>
+#include "datastructures.h"
+
+#ifndef READINPUT_H
+#define READINPUT_H
+
+#define READ_BUFFER_SIZE (1 << 20) //bytes pulled from input file per read(2)
+#define COMMAND_BUFFER_SIZE 4096 //commands decoded per refill
+
+struct InputPosition {
+	/*
+		Struct Name: InputPosition
+		Description: defines the position of the next command of an input file. Commands are 		decoded in batches, so it is the start of the batch holding the command and the 		number of commands of the batch before it.
+	*/
+	uint64_t offset; //file offset of first command line of batch, index of first command if binary
+	int last_command_num; //argument of command before the batch
+	int skip; //commands of batch before the next one
+};
+
+class InputFile {
+	/*
+		Class Name: InputFile
+		Description: holds the processes as read from input file and hands out its commands 		one by one. The file is opened by openInputFile() and the processes are read by 		initProcess(), in that order.
+	*/
+private:
+	//text input
+	int input_fd; //file descriptor of text input file
+	char *read_buffer; //raw bytes of input file
+	char *read_pos; //next unconsumed byte in read_buffer
+	char *read_end; //one past the last valid byte in read_buffer
+	bool read_eof; //whether input file is exhausted
+	off_t read_offset; //file offset of read_end
+	off_t commands_offset; //file offset of first command line
+	int last_command_num; //argument of last decoded text command
+
+	//binary input
+	bool binary_input; //whether input file is in binary trace format
+	const char *trace_base; //start of the memory mapped trace
+	size_t trace_size; //size of the memory mapped trace
+	const uint32_t *trace_commands; //first packed command
+	uint64_t trace_num_commands; //total number of packed commands
+	uint64_t trace_curr; //index of next command to be replayed
+
+	Command *command_buffer; //decoded commands handed out to simulator
+	int command_count; //number of valid commands in command_buffer
+	int command_pos; //next command to be handed out
+	InputPosition batch_start; //position of first command in command_buffer
+
+	bool nextLine(char **line, char **line_end);
+	bool nextInputLine(char **line, char **line_end);
+	int getNextTextCommands(Command *commands, int max);
+	bool refillCommands();
+
+	bool openBinaryTrace(char *filename);
+	void initProcessBinary();
+	int getNextBinaryCommands(Command *commands, int max);
+	void rewindBinaryTrace();
+
+public:
+	Process **processes; //holds all the processes as read from input file
+	int num_processes; //total number of processes using the system
+	int vpage_bits; //width of virtual address space in pages
+	std::vector<uint64_t> *next_uses; //next use of every reference, computed on first use by OPT
+	uint64_t file_size; //size of input file, with file_mtime it tells input files apart
+	int64_t file_mtime; //last modification of input file, in nanoseconds
+
+	InputFile(int vpage_bits);
+	~InputFile();
+
+	void openInputFile(char *filename);
+	void initProcess();
+	bool getNextCommand(Command *command);
+	void rewindInput();
+	InputPosition tellInput();
+	void seekInput(InputPosition position);
+};
+
+#endif
@@ -5,372 +5,1111 @@
 #include <stdio.h>
 #include <vector>
 #include "pager.h"
-#include "datastructures.h"
+#include "simulator.h"
 
-/*************************** imported from main.cpp ***************************/
-extern int curr_frame_index;
-extern int frame_limit;
-extern Frame **frame_table;
-extern Process **processes;
-extern int num_processes;
-extern bool O_flag, P_flag, F_flag, S_flag, x_flag, y_flag, f_flag, a_flag;
-extern char algo;
 
+#define SIMULATE_BATCH_SIZE 4096 //commands handed to the simulation loop at once
 
-/*************************** imported from readinput.cpp ***************************/
-extern char* getNextLine();
 
+/*************************** imported from readinput.cpp ***************************/
+extern void initPageTable(Process *process);
+extern void clearPageTable(Process *process);
 
-/*************************** Global Variables ***************************/
-Pager *pager;
-std::vector<unsigned int> age (frame_limit);
 
+/*************************** imported from stackdistance.cpp ***************************/
+extern std::vector<uint64_t>* get_next_uses(InputFile *input);
 
-/*************************** Function Definition ***************************/
-Frame* allocate_from_free_list();
-Frame* get_frame();
-void print_frame_table();
-void print_age();
 
-void simulate() {
+template <class PagerType, bool O_trace, bool x_trace, bool f_trace, bool extended>
+void run_commands(Simulator *simulator, Command *commands, int count) {
 	/*
-		Function Name: simulate
+		Function Name: run_commands
+		Arguments:
+			Simulator *simulator: simulator the commands are fed to
+			Command *commands: commands to be simulated
+			int count: number of commands
 		Returns: void
-		Description: simulates the memory management
+		Description: simulation loop specialized for a pager, per instruction output flags 		and whether any of TLB, huge pages, simulated time and kswapd is on
 	*/
-	char cmd; //command
-	int cmd_num; //number provided along with command
-	int curr_proc = -1; //current context
-	Frame *frame = NULL; //current frame
-	PTE **page_table = NULL; //current page table
+	for(int i = 0; i < count; i++) {
+		simulator->simulate_command<PagerType, O_trace, x_trace, f_trace, extended>(commands[i]);
+	}
+}
+
+
+template <class PagerType, bool extended>
+CommandRunner select_output_runner(bool O_flag, bool x_flag, bool f_flag) {
+	/*
+		Function Name: select_output_runner
+		Arguments:
+			bool O_flag, x_flag, f_flag: per instruction output flags
+		Returns: CommandRunner - simulation loop of the pager for the flags
+	*/
+	if(O_flag) {
+		if(x_flag) return f_flag ? run_commands<PagerType, true, true, true, extended> : run_commands<PagerType, true, true, false, extended>;
+		return f_flag ? run_commands<PagerType, true, false, true, extended> : run_commands<PagerType, true, false, false, extended>;
+	}
+	if(x_flag) return f_flag ? run_commands<PagerType, false, true, true, extended> : run_commands<PagerType, false, true, false, extended>;
+	return f_flag ? run_commands<PagerType, false, false, true, extended> : run_commands<PagerType, false, false, false, extended>;
+}
+
+
+template <class PagerType>
+CommandRunner select_runner(bool O_flag, bool x_flag, bool f_flag, bool extended) {
+	/*
+		Function Name: select_runner
+		Arguments:
+			bool O_flag, x_flag, f_flag: per instruction output flags
+			bool extended: whether any of TLB, huge pages, simulated time and kswapd is on
+		Returns: CommandRunner - simulation loop of the pager for the flags and features
+	*/
+	if(extended) return select_output_runner<PagerType, true>(O_flag, x_flag, f_flag);
+	return select_output_runner<PagerType, false>(O_flag, x_flag, f_flag);
+}
+
+
+Simulator::Simulator(SimulatorConfig config, InputFile *input) : allocator(config.frame_limit, (config.huge_pages > 0) ? config.huge_pages : 1), random(config.random_table), out(config.output_fd) {
+	/*
+		Function Name: constructor
+		Arguments:
+			SimulatorConfig config: options of simulation
+			InputFile *input: input file whose processes are simulated, only their VMAs are used
+		Description: creates processes with their page tables, the frame table and the pager. 		With huge pages frames are allocated in chunks of the huge page size.
+	*/
+	algo = config.algo;
+	O_flag = config.O_flag;
+	P_flag = config.P_flag;
+	F_flag = config.F_flag;
+	S_flag = config.S_flag;
+	x_flag = config.x_flag;
+	f_flag = config.f_flag;
 
-	//summary stats info variables
-	unsigned long int instr_num = 0, ctx_switches = 0, reads = 0, writes = 0;
+	//initialize page table of all the processes from their VMAs, a partition of local
+	//replacement only ever sees commands of its own process
+	num_processes = input->num_processes;
+	partition = config.partition;
+	processes = (Process**)malloc(sizeof(Process*)*num_processes);
+	for(int i = 0; i < num_processes; i++) {
+		processes[i] = new Process(i, config.vpage_bits);
+		programs.push_back(input->processes[i]->vmas);
+		if(partition >= 0 && partition != i) continue;
+		processes[i]->vmas = input->processes[i]->vmas;
+		initPageTable(processes[i]);
+	}
+	sharing = false;
+
+	//initialize the frame table
+	frame_limit = config.frame_limit;
+	frame_table = (Frame*)malloc(sizeof(Frame)*frame_limit);
+	for(int i = 0; i < frame_limit; i++) {
+		frame_table[i].process_id = -1;
+		frame_table[i].page_number = -1;
+		frame_table[i].frame_number = i;
+		frame_table[i].pte = NULL;
+		frame_table[i].refcount = 0;
+		frame_table[i].next_mapping = -1;
+		frame_table[i].cow = false;
+	}
 
-	//initialize the pager as per per algorithm provided
+	//initialize the pager as per per algorithm provided, along with the simulation loop
+	//specialized for it and the output flags. The features checked on every reference are
+	//compiled out of the loop for a simulation without any of them
+	bool extended = config.tlb.l1_entries > 0 || config.huge_pages > 0 || config.kswapd.timed || config.kswapd.low > 0;
 	if(algo == 'f') {
-		pager = new FIFOPager();
+		pager = new FIFOPager(frame_table, frame_limit, &random);
+		runner = select_runner<FIFOPager>(O_flag, x_flag, f_flag, extended);
 	} else if(algo == 's') {
-		pager = new SecondChancePager();
+		pager = new SecondChancePager(frame_table, frame_limit, &random);
+		runner = select_runner<SecondChancePager>(O_flag, x_flag, f_flag, extended);
 	} else if(algo == 'r') {
-		pager = new RandomPager();
+		pager = new RandomPager(frame_table, frame_limit, &random);
+		runner = select_runner<RandomPager>(O_flag, x_flag, f_flag, extended);
 	} else if(algo == 'n') {
-		pager = new NRUPager();
+		pager = new NRUPager(frame_table, frame_limit, &random);
+		runner = select_runner<NRUPager>(O_flag, x_flag, f_flag, extended);
 	} else if(algo == 'c') {
-		pager = new ClockPager();
+		pager = new ClockPager(frame_table, frame_limit, &random);
+		runner = select_runner<ClockPager>(O_flag, x_flag, f_flag, extended);
 	} else if(algo == 'a') {
-		pager = new AgingPager();
-		for(int i = 0; i < frame_limit; i++) {
-			age.push_back(0);
+		pager = new AgingPager(frame_table, frame_limit, &random);
+		runner = select_runner<AgingPager>(O_flag, x_flag, f_flag, extended);
+	} else if(algo == 'l') {
+		pager = new LRUPager(frame_table, frame_limit, &random);
+		runner = select_runner<LRUPager>(O_flag, x_flag, f_flag, extended);
+	} else if(algo == 'u') {
+		pager = new LFUPager(frame_table, frame_limit, &random);
+		runner = select_runner<LFUPager>(O_flag, x_flag, f_flag, extended);
+	} else if(algo == 'A') {
+		pager = new ARCPager(frame_table, frame_limit, &random, config.kswapd.low > 0);
+		runner = select_runner<ARCPager>(O_flag, x_flag, f_flag, extended);
+	} else if(algo == 'q') {
+		pager = new TwoQPager(frame_table, frame_limit, &random);
+		runner = select_runner<TwoQPager>(O_flag, x_flag, f_flag, extended);
+	} else if(algo == 'p') {
+		pager = new ClockProPager(frame_table, frame_limit, &random);
+		runner = select_runner<ClockProPager>(O_flag, x_flag, f_flag, extended);
+	} else if(algo == 'o') {
+		pager = new OPTPager(frame_table, frame_limit, &random, get_next_uses(input));
+		runner = select_runner<OPTPager>(O_flag, x_flag, f_flag, extended);
+	} else {
+		fprintf(stderr, "unknown algorithm %c\n", algo);
+		exit(1);
+	}
+	referenced_bits = pager->referenced_bitmap();
+
+	curr_proc = -1;
+	page_table = NULL;
+	started = false;
+	instr_num = ctx_switches = reads = writes = 0;
+	checkpoint_path = NULL;
+	checkpoint_interval = 0;
+	output_offset = 0;
+	event_ring = NULL;
+	event_batch = NULL;
+	event_count = 0;
+
+	//translations are cached in a TLB if one is configured
+	tlb_config = config.tlb;
+	huge = NULL;
+	if(config.huge_pages > 0) {
+		int bits = 0;
+		while((1 << bits) < config.huge_pages) bits++;
+		huge = new HugePages(bits, allocator.chunks());
+	}
+	tlb = (config.tlb.l1_entries > 0) ? new TLB(config.tlb, (huge != NULL) ? huge->bits : 0) : NULL;
+
+	//simulated time is kept on a disk model if asked for, kswapd needs it
+	kswapd_config = config.kswapd;
+	disk = kswapd_config.timed ? new Disk(kswapd_config.io_latency) : NULL;
+	io_wait = background_cost = 0;
+	kswapd_wakeups = kswapd_batches = kswapd_reclaimed = kswapd_written = 0;
+	direct_reclaims = writeback_stalls = 0;
+	if(kswapd_config.low > 0) reclaimed.resize(kswapd_config.batch);
+}
+
+
+Simulator::~Simulator() {
+	//references and faults the counters of the profiler are normalized by
+	PROFILE_WORK(reads + writes, get_faults());
+	delete pager;
+	delete tlb;
+	delete huge;
+	delete disk;
+	for(int i = 0; i < num_processes; i++) {
+		delete processes[i];
+	}
+	free(processes);
+	free(frame_table);
+}
+
+
+void Simulator::simulate(InputFile *input) {
+	/*
+		Function Name: simulate
+		Arguments:
+			InputFile *input: input file the simulator was created for
+		Returns: void
+		Description: simulates the memory management for all commands of input file. Writes 		a snapshot every checkpoint_interval commands if checkpoint_path is set
+	*/
+	Command commands[SIMULATE_BATCH_SIZE]; //decoded input commands
+	unsigned long int since_checkpoint = 0; //commands simulated since last snapshot
+	while(true) {
+		int count = 0;
+		while(count < SIMULATE_BATCH_SIZE && input->getNextCommand(&commands[count])) count++;
+		if(count == 0) break;
+		simulate_commands(commands, count);
+
+		//snapshots are taken between batches, where no command is half done
+		since_checkpoint += count;
+		if(checkpoint_path != NULL && since_checkpoint >= checkpoint_interval) {
+			if(!save_checkpoint(input, checkpoint_path)) exit(1);
+			since_checkpoint = 0;
 		}
 	}
+	print_summary();
+}
 
-	char *line = NULL; //buffer for holding input line
-	line = getNextLine();
-	sscanf(line, "%c %d", &cmd, &cmd_num);
+
+template <class PagerType, bool O_trace, bool x_trace, bool f_trace, bool extended>
+void Simulator::simulate_command(Command &command) {
+	/*
+		Function Name: simulate_command
+		Arguments:
+			Command &command: next command of input
+		Returns: void
+		Description: simulates the memory management for one command. Instantiated for every 		pager and combination of per instruction output flags, so the pager is called 		directly and disabled output costs nothing. Without extended the TLB, huge pages, 		simulated time and kswapd are known to be off and are not checked
+	*/
+	char cmd = command.cmd; //command
+	int cmd_num = command.num; //number provided along with command
+	Frame *frame = NULL; //current frame
 
 	//load the context as first command is always context
-	page_table = processes[cmd_num]->page_table; 
-	curr_proc = cmd_num;
-	ctx_switches++;
+	if(!started) {
+		started = true;
+		page_table = &processes[cmd_num]->page_table; 
+		curr_proc = cmd_num;
+		ctx_switches++;
+
+		//print info as per flags
+		if(O_trace)
+			trace(TRACE_COMMAND, cmd, cmd_num, instr_num);
+		return;
+	}
+
+	instr_num++;
 
 	//print info as per flags
-	if(O_flag)
-		printf("%lu: ==> %c %d\n", instr_num, cmd, cmd_num);
-	
+	if(O_trace)
+		trace(TRACE_COMMAND, cmd, cmd_num, instr_num);
 
-	while(line = getNextLine()) {
-		instr_num++;
+	//context switch
+	if(cmd == 'c') {
+		ctx_switches++;
+		
+		//load context as specified in argument of command
+		page_table = &processes[cmd_num]->page_table;
+		curr_proc = cmd_num;
+		if(extended && tlb != NULL && tlb->flush_on_switch) tlb->flush();
 
-		sscanf(line, "%c %d", &cmd, &cmd_num);
+		//print info as per flags
+		if(x_trace)
+			print_page_table(curr_proc);
+		if(f_trace) {
+			print_frame_table();
+			print_age();
+		}
+
+		//move onto next command
+		return;
+	} 
+
+	//fork, exec and exit replace a whole address space, they are rare enough to be handled
+	//out of line
+	else if(cmd == 'f' || cmd == 'e' || cmd == 'x') {
+		if(cmd == 'f')
+			fork_process(cmd_num);
+		else if(cmd == 'e')
+			exec_process(cmd_num);
+		else
+			exit_process();
 
 		//print info as per flags
-		if(O_flag)
-			printf("%lu: ==> %c %d\n", instr_num, cmd, cmd_num);
+		if(x_trace)
+			print_page_table(curr_proc);
+		if(f_trace) {
+			print_frame_table();
+			print_age();
+		}
+		return;
+	}
 
-		//context switch
-		if(cmd == 'c') {
-			ctx_switches++;
-			
-			//load context as specified in argument of command
-			page_table = processes[cmd_num]->page_table;
-			curr_proc = cmd_num;
+	//otherwise it is a read or write command
+	else {
+		//get the pte of specified page, from the TLB if it has an entry
+		PTE *pte = NULL;
+		if(extended && tlb != NULL) {
+			int level;
+			bool huge_hit;
+			pte = tlb->lookup(curr_proc, cmd_num, &level, &huge_hit);
+			if(pte == NULL) processes[curr_proc]->tlb_walks++;
+			else if(level == 1) processes[curr_proc]->tlb_hits++;
+			else processes[curr_proc]->tlb_l2_hits++;
+			if(huge_hit) processes[curr_proc]->tlb_huge_hits++;
+		}
+		bool walked = (pte == NULL);
+		if(walked) {
+			PROFILE_SCOPE("PageTable::lookup");
+			pte = page_table->lookup(cmd_num);
+		}
+
+		//if invalid then raise SEgV
+		if(!pte->valid) {
+			if(O_trace)
+				trace(TRACE_SEGV);
+			processes[curr_proc]->seg_v++;
+			reads++;
 
 			//print info as per flags
-			if(x_flag)
-				processes[curr_proc]->print_page_table();
-			if(f_flag) {
+			if(x_trace)
+				print_page_table(curr_proc);
+			if(f_trace) {
 				print_frame_table();
 				print_age();
 			}
 
 			//move onto next command
-			continue;
-		} 
+			return;
+		}
 
-		//otherwise it is a read or write command
-		else {
-			//get the pte of specified page
-			PTE *pte = page_table[cmd_num];
+		//a write to a page shared copy-on-write faults and gets a private copy of it
+		bool copy = false;
+		if(pte->frame_assigned) {
+			frame = &frame_table[pte->frame_index];
+			if(cmd != 'r' && frame->cow && frame->refcount > 1 && !pte->write_protected) {
+				remove_mapping(frame, curr_proc, cmd_num);
+				pte->frame_assigned = 0;
+				if(extended && tlb != NULL && tlb->invalidate(curr_proc, cmd_num))
+					processes[curr_proc]->tlb_shootdowns++;
+				walked = true;
+				copy = true;
+			}
+		}
 
-			//if invalid then raise SEgV
-			if(!pte->valid) {
-				if(O_flag)
-					printf(" SEGV\n");
-				processes[curr_proc]->seg_v++;
-				reads++;
+		//if it is not in physical memory then look for a frame to be allocated
+		bool faulted = !pte->frame_assigned;
+		if(faulted) {
+			//the latency of a fault is the time until its page is mapped
+			unsigned long long int fault_start = 0;
+			if(extended && disk != NULL) {
+				fault_start = get_time();
+				retire_writeback(fault_start);
+			}
 
-				//print info as per flags
-				if(x_flag)
-					processes[curr_proc]->print_page_table();
-				if(f_flag) {
-					print_frame_table();
-					print_age();
-				}
+			static_cast<PagerType*>(pager)->PagerType::page_fault(curr_proc, cmd_num);
+			frame = get_frame<PagerType, extended>(cmd_num);
 
-				//move onto next command
-				continue;
+			//if frame is being used for the first time
+			if(frame->process_id == -1) {
+				PROFILE_SCOPE("simulate: FIN/IN/ZERO/MAP");
+				load_page<O_trace>(frame, pte, cmd_num, copy);
 			}
 
-			//if it is not in physical memory then look for a frame to be allocated
-			if(!pte->frame_assigned) {
-				frame = get_frame();
-			} 
-			//otherwise directly use the frame
+			//otherwise there is some other page on the frame and it has to be replaced, a
+			//modified one is written out while the fault waits
 			else {
-				frame = frame_table[pte->frame_index];
+				PROFILE_SCOPE("simulate: UNMAP/OUT/FOUT/FIN/IN/ZERO/MAP");
+				bool write = (extended && disk != NULL && frame->pte->modified);
+				unsigned long int transfer = frame->pte->file_mapped ? FILE_TRANSFER_TIME : SWAP_TRANSFER_TIME;
+				unmap_frame<O_trace>(frame);
+				if(write) wait_io(transfer);
+				load_page<O_trace>(frame, pte, cmd_num, copy);
 			}
-			
-			//if frame is being used for the first time
-			if(frame->process_id == -1) {
-
-				//if file mapped then fin
-				if(pte->file_mapped) {
-					pte->referenced = 0;
-					pte->modified = 0;
-					if(O_flag) {
-						printf(" FIN\n");
-					}
-					processes[curr_proc]->fin++;
-				}
-				//if paged out then in
-				else if(pte->paged_out) {
-					pte->referenced = 0;
-					pte->modified = 0;
-					if(O_flag)
-						printf(" IN\n");
-					processes[curr_proc]->pin++;
-				} 
-				else {
-					if(O_flag)
-						printf(" ZERO\n");
-					processes[curr_proc]->zero++;
-				}
-
-				
-				//print info as per flags
-				if(O_flag)
-					printf(" MAP %d\n", frame->frame_number);
-
-				//map the page to memory
-				processes[curr_proc]->maps++;
-
-				//update the info in PTE and Frame
-				pte->frame_assigned = 1;
-				pte->frame_index = frame->frame_number;
-				frame->process_id = curr_proc;
-				frame->page_number = cmd_num;
-			} 
-
-			//if there is some other page on the frame then it has to be replaced
-			else if(frame->process_id != curr_proc || frame->page_number != cmd_num) {
-				//print info as per flags
-				if(O_flag)
-					printf(" UNMAP %d:%d\n", frame->process_id, frame->page_number);
-
-				//unmap the frame that is there in the memory
-				processes[frame->process_id]->unmaps++;
-				PTE *target_pte = processes[frame->process_id]->page_table[frame->page_number];
-				target_pte->frame_assigned = 0;
-				
-				
-				//if the page was modified then it needs to be framed out
-				if(target_pte->modified) {
-
-					//if file mapped then it is file out otherwise page out
-					if(target_pte->file_mapped) {
-						//print info as per flags
-						if(O_flag)
-							printf(" FOUT\n");
-
-						//fout as file mapped
-						processes[frame->process_id]->fout++;
-					} else {
-						//print info as per flags
-						if(O_flag)
-							printf(" OUT\n");
-
-						//page out as it was modified
-						target_pte->paged_out = 1;
-						processes[frame->process_id]->pout++;
-					}
-				}
-				
-				//if page to be loaded is file mapped then fin
-				if(pte->file_mapped) {
-					pte->referenced = 0;
-					pte->modified = 0;
-
-					//print info as per flags
-					if(O_flag) {
-						printf(" FIN\n");
-					}
-					processes[curr_proc]->fin++;
-				}
-
-				//if the page was paged out then it is page in
-				else if(pte->paged_out) {
-					pte->referenced = 0;
-					pte->modified = 0;
-					if(O_flag)
-						printf(" IN\n");
-					processes[curr_proc]->pin++;
-				} 
-
-				//otherwise zero the memory and map the page to memory
-				else {
-					if(O_flag)
-						printf(" ZERO\n");
-					processes[curr_proc]->zero++;
-				}
-
-				if(O_flag)
-					printf(" MAP %d\n", frame->frame_number);
-				processes[curr_proc]->maps++;
 
+			if(extended && disk != NULL) fault_latency.add(get_time() - fault_start);
+		}
 
-				//update PTE and Frame
-				pte->frame_assigned = 1;
-				pte->frame_index = frame->frame_number;
-				frame->process_id = curr_proc;
-				frame->page_number = cmd_num;
-			}
+		//a walked page is in memory now and gets an entry, the one of its huge page if it is
+		//part of one
+		if(extended && walked && tlb != NULL) {
+			HugeRegion *region = (huge != NULL) ? huge->region_of(frame->frame_number) : NULL;
+			tlb->insert(curr_proc, cmd_num, pte, region != NULL && region->promoted);
+		}
 
-			//update other pte flags and print the info as per flags
-			pte->referenced = 1;
-			if(cmd == 'r') {
+		//update other pte flags and print the info as per flags, the bits of a shared frame
+		//are kept in the PTE of its first mapping as that is the one pagers look at
+		PTE *frame_pte = frame->pte;
+		pte->referenced = 1;
+		frame_pte->referenced = 1;
+		if(cmd == 'r') {
+			reads++;
+		} else {
+			if(pte->write_protected) {
+				if(O_trace)
+					trace(TRACE_SEGPROT);
+				processes[curr_proc]->seg_p++;
 				reads++;
-			} else {
-				if(pte->write_protected) {
-					if(O_flag)
-						printf(" SEGPROT\n");
-					processes[curr_proc]->seg_p++;
-					reads++;
-					if(x_flag)
-						processes[curr_proc]->print_page_table();
-					if(f_flag) {
-						print_frame_table();
-						print_age();
-					}
-					continue;
+				static_cast<PagerType*>(pager)->PagerType::reference_frame(frame);
+				if(extended && faulted && kswapd_config.low > 0)
+					run_kswapd<PagerType, O_trace>();
+				if(x_trace)
+					print_page_table(curr_proc);
+				if(f_trace) {
+					print_frame_table();
+					print_age();
 				}
-				pte->modified = 1;
-				writes++;
-			}
-			if(x_flag)
-				processes[curr_proc]->print_page_table();
-			if(f_flag) {
-				print_frame_table();
-				print_age();
+				return;
 			}
+			pte->modified = 1;
+			frame_pte->modified = 1;
+			writes++;
 		}
-	}
+		static_cast<PagerType*>(pager)->PagerType::reference_frame(frame);
 
+		//kswapd runs once the page that faulted is known to the pager
+		if(extended && faulted && kswapd_config.low > 0)
+			run_kswapd<PagerType, O_trace>();
+		if(x_trace)
+			print_page_table(curr_proc);
+		if(f_trace) {
+			print_frame_table();
+			print_age();
+		}
+	}
+}
 
 
+void Simulator::print_summary() {
+	/*
+		Function Name: print_summary
+		Returns: void
+		Description: prints the final state and summary statistics as per flags
+	*/
 	//print the info as per flags
 	if(P_flag)
 		for(int i = 0; i < num_processes; i++) {
-			processes[i]->print_page_table();
+			print_page_table(i);
 		}
 
 	if(F_flag)
 		print_frame_table();
 
 	if(S_flag) {
-		unsigned long long int cost = 0;
 		for(int i = 0; i < num_processes; i++) {
-			processes[i]->print_stats();
-			cost += processes[i]->get_cost();
+			processes[i]->print_stats(out, tlb != NULL, sharing, huge != NULL);
+		}
+
+		if(disk != NULL) {
+			out.put("FAULTLAT: N=");
+			out.put_uint(fault_latency.count);
+			out.put(" MEAN=");
+			out.put_uint((fault_latency.count > 0) ? fault_latency.sum/fault_latency.count : 0);
+			out.put(" P50=");
+			out.put_uint(fault_latency.percentile(500));
+			out.put(" P90=");
+			out.put_uint(fault_latency.percentile(900));
+			out.put(" P99=");
+			out.put_uint(fault_latency.percentile(990));
+			out.put(" P999=");
+			out.put_uint(fault_latency.percentile(999));
+			out.put(" MAX=");
+			out.put_uint(fault_latency.max);
+			out.put(" TIME=");
+			out.put_uint(get_time());
+			out.put('\n');
+		}
+		if(kswapd_config.low > 0) {
+			out.put("KSWAPD: W=");
+			out.put_uint(kswapd_wakeups);
+			out.put(" B=");
+			out.put_uint(kswapd_batches);
+			out.put(" R=");
+			out.put_uint(kswapd_reclaimed);
+			out.put(" WB=");
+			out.put_uint(kswapd_written);
+			out.put(" D=");
+			out.put_uint(direct_reclaims);
+			out.put(" ST=");
+			out.put_uint(writeback_stalls);
+			out.put('\n');
 		}
 
-		cost += ctx_switches*121 + reads + writes;
+		unsigned long long int cost = get_total_cost();
+		out.put("TOTALCOST ");
+		out.put_uint(ctx_switches);
+		out.put(' ');
+		out.put_uint(instr_num+1);
+		out.put(' ');
+		out.put_uint(cost);
+		out.put('\n');
+	}
+
+	//summary is the last output of a simulation
+	out.flush();
+}
 
-		printf("TOTALCOST %lu %lu %llu\n", ctx_switches, instr_num+1, cost);
+
+unsigned long long int Simulator::get_total_cost() {
+	/*
+		Function Name: get_total_cost
+		Returns:
+			unsigned long long int: cost incurred by all processes and the simulator so far
+	*/
+	unsigned long long int cost = 0;
+	for(int i = 0; i < num_processes; i++) {
+		cost += processes[i]->get_cost();
 	}
+
+	cost += ctx_switches*121 + reads + writes;
+	return cost;
 }
 
 
-Frame* allocate_from_free_list() {
+unsigned long int Simulator::get_faults() {
+	/*
+		Function Name: get_faults
+		Returns:
+			unsigned long int: page faults of all processes so far, every one maps a page
+	*/
+	unsigned long int faults = 0;
+	for(int i = 0; i < num_processes; i++) {
+		faults += processes[i]->maps;
+	}
+	return faults;
+}
+
+
+Frame* Simulator::allocate_from_free_list() {
 	/*
 		Function Name: allocate_from_free_list
 		Returns: 
 			Frame*: frame to be allocated, NULL otherwises
-		Description: simply return the next frame if not exhausted of physical memory
+		Description: returns a free frame from the allocator if not exhausted of physical 		memory. Without huge pages, frames freed by exec or exit come first and the others 		are handed out in frame number order.
 	*/
-
-	//if not exhausted of physical memory then get the frame and increase the current index
-	if(curr_frame_index < frame_limit) {
-		Frame *frame = frame_table[curr_frame_index];
-		curr_frame_index++;
-		return frame;
-	} else {
-		return NULL;
-	}
+	int f = allocator.alloc_frame();
+	return (f == -1) ? NULL : &frame_table[f];
 }
 
 
-Frame* get_frame() {
+template <class PagerType, bool extended>
+Frame* Simulator::get_frame(int page_number) {
 	/*
 		Function Name: get_frame
+		Arguments:
+			int page_number: page of current process that needs a frame
 		Returns:
 			Frame*: get the frame, either from free list or from pager
-		Description: returns the frame to be used for the page that needs to be accessed
+		Description: returns the frame to be used for the page that needs to be accessed. 		With huge pages, the frame reserved for the page comes first, and a partly 		populated reservation is broken before the pager is asked for a victim. A victim in 		a huge page demotes it. With kswapd the fault waits for a frame being written back 		before it reclaims a victim directly.
 	*/
-	Frame *frame = allocate_from_free_list();
-	if(frame == NULL) frame = pager->determine_victim_frame();
+	PROFILE_SCOPE("Simulator::get_frame");
+	Frame *frame = (extended && huge != NULL) ? reserve_frame(page_number) : NULL;
+	if(frame == NULL) frame = allocate_from_free_list();
+	while(extended && frame == NULL && huge != NULL && huge->partial.size(0) > 0) {
+		break_reservation(huge->partial.back(0));
+		frame = allocate_from_free_list();
+	}
+
+	//frames kswapd is writing back are free soon, the fault waits for the first of them
+	//rather than write out a victim of its own
+	while(extended && frame == NULL && disk != NULL && !disk->writeback.empty()) {
+		wait_writeback();
+		frame = allocate_from_free_list();
+	}
+	if(frame == NULL) {
+		if(extended && kswapd_config.low > 0) direct_reclaims++;
+		frame = static_cast<PagerType*>(pager)->PagerType::determine_victim_frame();
+		if(extended && huge != NULL && huge->region_of(frame->frame_number) != NULL) break_reservation(frame->frame_number >> huge->bits);
+	}
 	return frame;
 }
 
-void print_age() {
+
+Frame* Simulator::reserve_frame(int page_number) {
+	/*
+		Function Name: reserve_frame
+		Arguments:
+			int page_number: page of current process that needs a frame
+		Returns:
+			Frame*: frame at the offset of page in the chunk reserved for its region, NULL if 			there is none
+		Description: a region without reservation gets one if it lies within a VMA, none of 		its pages is in memory and a whole chunk of frames is free
+	*/
+	int offset = page_number & (huge->size - 1);
+	int first_page = page_number - offset;
+	int c = huge->find(curr_proc, first_page);
+	if(c == -1) {
+		Process *process = processes[curr_proc];
+		bool inside = false;
+		for(int k = 0; k < (int)process->vmas.size() && !inside; k++) {
+			inside = (process->vmas[k].start_page <= first_page && first_page + huge->size - 1 <= process->vmas[k].end_page);
+		}
+		if(!inside) return NULL;
+
+		//PTEs of a region are contiguous, it lies within a leaf of page table
+		PTE *first_pte = page_table->lookup(first_page);
+		for(int i = 0; i < huge->size; i++) {
+			if(first_pte[i].frame_assigned) return NULL;
+		}
+		c = allocator.alloc_chunk();
+		if(c == -1) return NULL;
+		huge->reserve(c, curr_proc, first_page);
+	}
+	return &frame_table[(c << huge->bits) + offset];
+}
+
+
+void Simulator::populate_huge(Frame *frame) {
+	/*
+		Function Name: populate_huge
+		Arguments:
+			Frame *frame: frame a page of current process was just mapped to
+		Returns: void
+		Description: counts the page if frame is reserved for its region, a region whose 		pages are all in memory now is promoted. The entries of its base pages make way for 		the entry of the huge page.
+	*/
+	HugeRegion *region = huge->region_of(frame->frame_number);
+	if(region == NULL) return;
+	Process *process = processes[curr_proc];
+	process->huge_maps++;
+	if(!huge->populate(frame->frame_number >> huge->bits)) return;
+
+	region->promoted = true;
+	if(O_flag)
+		trace(TRACE_PROMOTE, 0, curr_proc, region->first_page);
+	process->promotions++;
+	if(tlb != NULL) {
+		for(int i = 0; i < huge->size; i++) {
+			if(tlb->invalidate(curr_proc, region->first_page + i)) process->tlb_shootdowns++;
+		}
+	}
+}
+
+
+void Simulator::break_reservation(int c) {
+	/*
+		Function Name: break_reservation
+		Arguments:
+			int c: reserved chunk
+		Returns: void
+		Description: demotes the region if it is a huge page and frees the frames of its 		pages not in memory. Its pages in memory stay where they are as base pages.
+	*/
+	HugeRegion &region = huge->regions[c];
+	if(region.promoted) {
+		Process *process = processes[region.process_id];
+		if(O_flag)
+			trace(TRACE_DEMOTE, 0, region.process_id, region.first_page);
+		process->demotions++;
+		if(tlb != NULL && tlb->invalidate_huge(region.process_id, region.first_page))
+			process->tlb_shootdowns++;
+	}
+	for(int f = c << huge->bits; f < (c + 1) << huge->bits; f++) {
+		if(frame_table[f].process_id == -1) allocator.free_frame(f);
+	}
+	huge->release(c);
+}
+
+
+void Simulator::release_reservations(int process_id) {
+	/*
+		Function Name: release_reservations
+		Arguments:
+			int process_id: process whose pages are about to be unmapped or shared
+		Returns: void
+		Description: breaks every reservation of process, as fork, exec and exit do
+	*/
+	for(int c = 0; c < (int)huge->regions.size(); c++) {
+		if(huge->regions[c].process_id == process_id) break_reservation(c);
+	}
+}
+
+
+unsigned long long int Simulator::get_time() {
+	/*
+		Function Name: get_time
+		Returns:
+			unsigned long long int: simulated time, the cost spent on the simulated CPU so far 			plus the time faults waited for the disk
+	*/
+	return get_total_cost() - background_cost + io_wait;
+}
+
+
+void Simulator::wait_io(unsigned long int transfer) {
+	/*
+		Function Name: wait_io
+		Arguments:
+			unsigned long int transfer: time the page takes to transfer, its cost was just 			counted
+		Returns: void
+		Description: the current fault issues a disk request for a page and waits for it. 		The transfer is part of TOTALCOST already, the wait for earlier requests and the 		latency are added.
+	*/
+	unsigned long long int now = get_time() - transfer;
+	unsigned long long int done = disk->request(now, transfer);
+	io_wait += done - now - transfer;
+}
+
+
+void Simulator::retire_writeback(unsigned long long int now) {
+	/*
+		Function Name: retire_writeback
+		Arguments:
+			unsigned long long int now: current simulated time
+		Returns: void
+		Description: frames whose writeback has completed by now are free
+	*/
+	while(!disk->writeback.empty() && disk->writeback.front().done <= now) {
+		allocator.free_frame(disk->writeback.front().frame_number);
+		disk->writeback.pop_front();
+	}
+}
+
+
+void Simulator::wait_writeback() {
+	/*
+		Function Name: wait_writeback
+		Returns: void
+		Description: the current fault waits until the first frame being written back is 		free, frames written by the same request are free with it
+	*/
+	unsigned long long int now = get_time();
+	unsigned long long int done = disk->writeback.front().done;
+	if(done > now) io_wait += done - now;
+	writeback_stalls++;
+	retire_writeback((done > now) ? done : now);
+}
+
+
+void Simulator::free_frame(Frame *frame) {
+	/*
+		Function Name: free_frame
+		Arguments:
+			Frame *frame: frame whose page was unmapped from every process
+		Returns: void
+		Description: leaves the frame without a page, the caller hands it to the allocator
+	*/
+	frame->process_id = -1;
+	frame->page_number = -1;
+	frame->pte = NULL;
+	frame->refcount = 0;
+	frame->next_mapping = -1;
+	frame->cow = false;
+}
+
+
+template <class PagerType, bool O_trace>
+void Simulator::run_kswapd() {
+	/*
+		Function Name: run_kswapd
+		Returns: void
+		Description: wakes kswapd if fewer than low frames are free or being written back. 		It asks the pager for batches of victims until high frames are. Clean victims are 		free right away, the modified ones of a batch are written out by a single disk 		request and are free once it completes. kswapd runs beside the simulated CPU, so 		its cost is left out of simulated time.
+	*/
+	int pool = allocator.free_count() + (int)disk->writeback.size();
+	if(pool >= kswapd_config.low) return;
+	PROFILE_SCOPE("Simulator::run_kswapd");
+	unsigned long long int cost = get_total_cost();
+	unsigned long long int now = get_time();
+	kswapd_wakeups++;
+	if(O_trace)
+		trace(TRACE_KSWAPD);
+
+	while(pool < kswapd_config.high) {
+		//the pager only has victims among frames holding a page, i.e. all but the free ones,
+		//the ones being written back and the ones reserved for pages of huge pages
+		int resident = frame_limit - pool - ((huge != NULL) ? huge->reserved_free : 0);
+		int count = kswapd_config.high - pool;
+		if(count > kswapd_config.batch) count = kswapd_config.batch;
+		if(count > resident) count = resident;
+		if(count <= 0) break;
+
+		int n = static_cast<PagerType*>(pager)->PagerType::reclaim_frames(&reclaimed[0], count);
+		int written = 0;
+		unsigned long int transfer = 0;
+		for(int i = 0; i < n; i++) {
+			Frame *frame = reclaimed[i];
+			if(huge != NULL && huge->region_of(frame->frame_number) != NULL) break_reservation(frame->frame_number >> huge->bits);
+			bool modified = frame->pte->modified;
+			if(modified) transfer += frame->pte->file_mapped ? FILE_TRANSFER_TIME : SWAP_TRANSFER_TIME;
+			unmap_frame<O_trace>(frame);
+			free_frame(frame);
+			if(modified) reclaimed[written++] = frame;
+			else allocator.free_frame(frame->frame_number);
+		}
+		if(written > 0) {
+			unsigned long long int done = disk->request(now, transfer);
+			for(int i = 0; i < written; i++) {
+				Writeback writeback = {reclaimed[i]->frame_number, done};
+				disk->writeback.push_back(writeback);
+			}
+		}
+		kswapd_batches++;
+		kswapd_reclaimed += n;
+		kswapd_written += written;
+		pool = allocator.free_count() + (int)disk->writeback.size();
+	}
+	background_cost += get_total_cost() - cost;
+}
+
+template <bool O_trace>
+void Simulator::load_page(Frame *frame, PTE *pte, int page_number, bool copy) {
+	/*
+		Function Name: load_page
+		Arguments:
+			Frame *frame: free frame the page is loaded into
+			PTE *pte: PTE of page of current process
+			int page_number: page to be loaded
+			bool copy: whether the page is a private copy of a page shared copy-on-write
+		Returns: void
+		Description: fills the frame with the content of the page and maps it, a page read 		from its file or swap waits for the disk if time is kept
+	*/
+	//a copy is taken from the frame still mapped by the other processes
+	if(copy) {
+		pte->referenced = 0;
+		pte->modified = 0;
+		if(O_trace)
+			trace(TRACE_COW);
+		processes[curr_proc]->cows++;
+	}
+
+	//if file mapped then fin
+	else if(pte->file_mapped) {
+		pte->referenced = 0;
+		pte->modified = 0;
+		if(O_trace)
+			trace(TRACE_FIN);
+		processes[curr_proc]->fin++;
+		if(disk != NULL) wait_io(FILE_TRANSFER_TIME);
+	}
+
+	//if paged out then in
+	else if(pte->paged_out) {
+		pte->referenced = 0;
+		pte->modified = 0;
+		if(O_trace)
+			trace(TRACE_IN);
+		processes[curr_proc]->pin++;
+		if(disk != NULL) wait_io(SWAP_TRANSFER_TIME);
+	}
+
+	//otherwise zero the memory
+	else {
+		if(O_trace)
+			trace(TRACE_ZERO);
+		processes[curr_proc]->zero++;
+	}
+
+	//map the page to memory
+	if(O_trace)
+		trace(TRACE_MAP, 0, frame->frame_number);
+	processes[curr_proc]->maps++;
+
+	//update PTE and Frame, the page is mapped once
+	pte->frame_assigned = 1;
+	pte->frame_index = frame->frame_number;
+	frame->process_id = curr_proc;
+	frame->page_number = page_number;
+	frame->pte = pte;
+	frame->refcount = 1;
+	frame->next_mapping = -1;
+	frame->cow = false;
+	if(huge != NULL) populate_huge(frame);
+}
+
+
+template <bool O_trace>
+void Simulator::unmap_pte(int process_id, int page_number, PTE *pte, bool page_out) {
+	/*
+		Function Name: unmap_pte
+		Arguments:
+			int process_id, int page_number: page being unmapped
+			PTE *pte: PTE of page
+			bool page_out: whether the content of the page goes to swap
+		Returns: void
+		Description: unmaps one mapping of a frame, its translation has to go too
+	*/
+	if(O_trace)
+		trace(TRACE_UNMAP, 0, process_id, page_number);
+	processes[process_id]->unmaps++;
+	if(tlb != NULL && tlb->invalidate(process_id, page_number))
+		processes[process_id]->tlb_shootdowns++;
+	pte->frame_assigned = 0;
+	if(page_out) pte->paged_out = 1;
+}
+
+
+template <bool O_trace>
+void Simulator::unmap_frame(Frame *frame) {
+	/*
+		Function Name: unmap_frame
+		Arguments:
+			Frame *frame: victim frame
+		Returns: void
+		Description: unmaps the page on the frame from every process mapping it. If it was 		modified it is written out once, charged to the process of the first mapping
+	*/
+	PTE *target_pte = frame->pte;
+	bool page_out = target_pte->modified && !target_pte->file_mapped;
+	unmap_pte<O_trace>(frame->process_id, frame->page_number, target_pte, page_out);
+	for(int m = frame->next_mapping; m != -1; m = rmap.at(m).next) {
+		Mapping &mapping = rmap.at(m);
+		unmap_pte<O_trace>(mapping.process_id, mapping.page_number, mapping.pte, page_out);
+	}
+	rmap.clear(frame);
+
+	//if the page was modified then it needs to be framed out
+	if(target_pte->modified) {
+
+		//if file mapped then it is file out otherwise page out
+		if(target_pte->file_mapped) {
+			if(O_trace)
+				trace(TRACE_FOUT);
+			processes[frame->process_id]->fout++;
+		} else {
+			if(O_trace)
+				trace(TRACE_OUT);
+			processes[frame->process_id]->pout++;
+		}
+	}
+}
+
+
+void Simulator::release_pages(int process_id) {
+	/*
+		Function Name: release_pages
+		Arguments:
+			int process_id: process whose address space goes away
+		Returns: void
+		Description: unmaps every page of process in memory and removes its VMAs. Frames no 		other process maps are handed back to the free list. A modified file mapped page is 		written out when its last mapping goes, anonymous pages are dropped.
+	*/
+	Process *process = processes[process_id];
+	if(huge != NULL) release_reservations(process_id);
+	for(int k = 0; k < (int)process->vmas.size(); k++) {
+		for(int j = process->vmas[k].start_page; j <= process->vmas[k].end_page; j++) {
+			PTE *pte = process->page_table.lookup(j);
+			if(!pte->frame_assigned) continue;
+			Frame *frame = &frame_table[pte->frame_index];
+
+			if(O_flag)
+				trace(TRACE_UNMAP, 0, process_id, j);
+			process->unmaps++;
+			if(tlb != NULL && tlb->invalidate(process_id, j))
+				process->tlb_shootdowns++;
+			pte->frame_assigned = 0;
+			if(frame->refcount == 1 && frame->pte->modified && frame->pte->file_mapped) {
+				if(O_flag)
+					trace(TRACE_FOUT);
+				process->fout++;
+			}
+
+			remove_mapping(frame, process_id, j);
+			if(frame->refcount == 0) {
+				pager->release_frame(frame);
+				allocator.free_frame(frame->frame_number);
+			}
+		}
+	}
+	clearPageTable(process);
+}
+
+
+void Simulator::fork_process(int child) {
+	/*
+		Function Name: fork_process
+		Arguments:
+			int child: process that becomes a copy of current process
+		Returns: void
+		Description: replaces the address space of child with a copy of the one of current 		process. Pages in memory are not copied, their frames are mapped by both processes 		and private ones are copied on the first write by either. Translations of current 		process are flushed from the TLB as they lose write access.
+	*/
+	if(partition >= 0) {
+		fprintf(stderr, "fork is not supported in local replacement\n");
+		exit(1);
+	}
+	if(child < 0 || child >= num_processes || child == curr_proc) {
+		fprintf(stderr, "process %d can not fork into process %d\n", curr_proc, child);
+		exit(1);
+	}
+	Process *parent = processes[curr_proc];
+	Process *target = processes[child];
+	release_pages(child);
+
+	//huge pages are split, only base pages are shared
+	if(huge != NULL) release_reservations(curr_proc);
+
+	target->vmas = parent->vmas;
+	for(int k = 0; k < (int)parent->vmas.size(); k++) {
+		VMA &vma = parent->vmas[k];
+		for(int j = vma.start_page; j <= vma.end_page; j++) {
+			PTE *from = parent->page_table.lookup(j);
+			PTE *to = target->page_table.populate(j);
+			*to = *from;
+			to->referenced = 0;
+			to->modified = 0;
+			if(!from->frame_assigned) continue;
+
+			Frame *frame = &frame_table[from->frame_index];
+			rmap.add(frame, child, j, to);
+			if(!vma.shared) frame->cow = true;
+			parent->shares++;
+		}
+	}
+	parent->forks++;
+	if(tlb != NULL) tlb->flush_asid(curr_proc);
+	sharing = true;
+}
+
+
+void Simulator::exec_process(int program) {
+	/*
+		Function Name: exec_process
+		Arguments:
+			int program: process whose declared VMAs are loaded
+		Returns: void
+		Description: replaces the address space of current process with fresh VMAs
+	*/
+	if(program < 0 || program >= num_processes) {
+		fprintf(stderr, "process %d can not exec VMAs of process %d\n", curr_proc, program);
+		exit(1);
+	}
+	release_pages(curr_proc);
+	processes[curr_proc]->vmas = programs[program];
+	initPageTable(processes[curr_proc]);
+	processes[curr_proc]->execs++;
+	sharing = true;
+}
+
+
+void Simulator::exit_process() {
+	/*
+		Function Name: exit_process
+		Returns: void
+		Description: removes the address space of current process, its later references 		are SEGV
+	*/
+	release_pages(curr_proc);
+	processes[curr_proc]->exits++;
+	sharing = true;
+}
+
+
+void Simulator::print_age() {
 	/*
 		Function Name: print_age
 		Returns: void
 		Description: prints the age of all frames for aging algorithm
 	*/
+	PROFILE_SCOPE("Simulator::print_age");
 	if(algo == 'a') {
+		AgingPager *aging = (AgingPager*)pager;
 		for(int i = 0; i < frame_limit; i++) {
-			if(frame_table[i]->process_id != -1) {
-				printf("%d:%d ", i, age.at(i));
+			if(frame_table[i].process_id != -1) {
+				out.put_int(i);
+				out.put(':');
+				out.put_int((int)aging->get_age(i));
+				out.put(' ');
 			}
 		}
-		printf("\n");
+		out.put('\n');
+	}
+}
+
+void Simulator::print_page_table(int process_id) {
+	/*
+		Function Name: print_page_table
+		Arguments:
+			int process_id: process whose page table is printed
+		Returns: void
+		Description: prints the page table, with the referenced bits the pager keeps if any
+	*/
+	processes[process_id]->print_page_table(out, frame_table, referenced_bits);
+}
+
+void Simulator::remove_mapping(Frame *frame, int process_id, int page_number) {
+	/*
+		Function Name: remove_mapping
+		Arguments:
+			Frame *frame: frame mapped by page
+			int process_id, page_number: page whose mapping is removed
+		Returns: void
+		Description: removes the mapping from the reverse map. If the pager keeps the 		referenced bits, the bit of the frame is written to the PTE of its first mapping 		before, as the next mapping inherits it, and read back after.
+	*/
+	if(referenced_bits == NULL) {
+		rmap.remove(frame, process_id, page_number);
+		return;
 	}
+	frame->pte->referenced = referenced_bits->test(frame->frame_number);
+	rmap.remove(frame, process_id, page_number);
+	if(frame->pte != NULL && frame->pte->referenced)
+		referenced_bits->set(frame->frame_number);
 }
 
-void print_frame_table() {
+void Simulator::print_frame_table() {
 	/*
 		Function Name: print_frame_table
 		Returns: void
 		Description: print the frame table in the required format
 	*/
-	printf("FT: ");
+	PROFILE_SCOPE("Simulator::print_frame_table");
+	out.put("FT: ");
 	for(int i = 0; i < frame_limit; i++) {
-		if(frame_table[i]->process_id == -1) {
-			printf("* ");
+		if(frame_table[i].process_id == -1) {
+			out.put("* ");
 		} else {
-			printf("%d:%d ", frame_table[i]->process_id, frame_table[i]->page_number);
+			out.put_int(frame_table[i].process_id);
+			out.put(':');
+			out.put_int(frame_table[i].page_number);
+			out.put(' ');
 		}
 	}
-	printf("\n");
-}
\ No newline at end of file
+	out.put('\n');
+}
@@ -0,0 +1,169 @@
+/*
+	Module Name: simulator.h
+	Description: Defines the Simulator class. A Simulator owns the complete state of one 		simulation: processes with their page tables, the frame table with the reverse map of 		shared frames and the allocator of free frames, the pager, the position in random 		numbers and the simulated time. Several simulators can 		run side by side.
+*/
+#include "datastructures.h"
+#include "readinput.h"
+#include "random.h"
+#include "output.h"
+#include "pipeline.h"
+#include "tlb.h"
+#include "hugepage.h"
+#include "kswapd.h"
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+class Pager;
+class Simulator;
+
+//simulation loop specialized for a pager, the output flags and whether TLB, huge pages, time or
+//kswapd are on, chosen once per simulation
+typedef void (*CommandRunner)(Simulator *simulator, Command *commands, int count);
+
+struct SimulatorConfig {
+	/*
+		Struct Name: SimulatorConfig
+		Description: defines the options a simulation is run with
+	*/
+	char algo; //algorithm to be implemented
+	int frame_limit; //memory size
+	int vpage_bits; //width of virtual address space in pages
+	bool O_flag, P_flag, F_flag, S_flag, x_flag, f_flag; //flags provided in option
+	int output_fd; //file descriptor output is written to
+	const RandomTable *random_table; //random numbers of rfile, shared read-only
+	int partition; //only process whose pages are populated in local replacement, -1 for all
+	TLBConfig tlb; //geometry of TLB, 0 L1 entries for none
+	int huge_pages; //pages per huge page, a power of 2, 0 for no huge pages
+	KswapdConfig kswapd; //simulated time and kswapd, all 0 for none
+};
+
+class Simulator {
+	/*
+		Class Name: Simulator
+		Description: simulates memory management of a set of processes on a fixed number of 		frames. Commands are fed one at a time through simulate_command().
+	*/
+public:
+	Process **processes; //holds all the processes
+	int num_processes; //total number of processes using the system
+	int frame_limit; //memory size
+	Frame *frame_table; //holds all the frames, stored contiguously
+	FrameAllocator allocator; //frames no page is mapped to, handed out before the pager is asked for a victim
+	HugePages *huge; //reservations of huge pages, NULL for no huge pages
+	ReverseMap rmap; //mappings of frames shared by fork beyond their first one
+	std::vector<std::vector<VMA> > programs; //VMAs every process was declared with, loaded by exec
+	int partition; //only process simulated in local replacement, -1 for all
+	bool sharing; //whether a fork, exec or exit was simulated, their counters are printed then
+	Pager *pager; //pager implementing the algorithm
+	ReferencedBitmap *referenced_bits; //referenced bits of frames if pager keeps them instead of the PTEs, NULL otherwise
+	CommandRunner runner; //simulation loop specialized for pager, output flags and features on
+	RandomGenerator random; //position in random numbers of rfile
+	char algo; //algorithm to be implemented
+	bool O_flag, P_flag, F_flag, S_flag, x_flag, f_flag; //flags provided in option
+	OutputBuffer out; //all output of simulation goes through it
+	TLB *tlb; //caches translations of recently referenced pages, NULL for no TLB
+	TLBConfig tlb_config; //geometry of tlb
+	SpscRing<TraceEvent> *event_ring; //format stage O output goes to, NULL to format it directly
+	TraceEvent *event_batch; //O output not yet pushed to event_ring
+	int event_count; //events in event_batch
+
+	int curr_proc; //current context
+	PageTable *page_table; //current page table
+	bool started; //whether the first command, always a context switch, was seen
+
+	//summary stats info variables
+	unsigned long int instr_num, ctx_switches, reads, writes;
+
+	//simulated time, kept if kswapd_config.timed. It is the cost of TOTALCOST spent on the
+	//simulated CPU plus the time faults waited for the disk
+	KswapdConfig kswapd_config; //options of simulated time and kswapd
+	Disk *disk; //device pages are read from and written to, NULL if no time is kept
+	LatencyHistogram fault_latency; //time from fault to map of every page fault
+	unsigned long long int io_wait; //time faults waited for disk beyond the cost of their transfers
+	unsigned long long int background_cost; //cost of TOTALCOST spent by kswapd, not on the simulated CPU
+	unsigned long int kswapd_wakeups, kswapd_batches, kswapd_reclaimed, kswapd_written; //work of kswapd
+	unsigned long int direct_reclaims, writeback_stalls; //faults that found no free frame
+	std::vector<Frame*> reclaimed; //victims of a batch of kswapd
+
+	//checkpoints, a snapshot of the simulation is written every checkpoint_interval commands
+	const char *checkpoint_path; //snapshot file, NULL for no checkpoints
+	unsigned long int checkpoint_interval; //commands between two snapshots
+	unsigned long long int output_offset; //bytes of output written before the simulation was resumed
+
+	Simulator(SimulatorConfig config, InputFile *input);
+	~Simulator();
+
+	void simulate(InputFile *input);
+	void simulate_pipelined(InputFile *input, int num_stages);
+	void push_events();
+	template <class PagerType, bool O_trace, bool x_trace, bool f_trace, bool extended>
+	void simulate_command(Command &command);
+
+	void simulate_commands(Command *commands, int count) {
+		/*
+			Function Name: simulate_commands
+			Arguments:
+				Command *commands: next commands of input
+				int count: number of commands
+			Returns: void
+		*/
+		PROFILE_SCOPE("Simulator::simulate_commands");
+		runner(this, commands, count);
+	}
+	void print_summary();
+	void state(Snapshot &snapshot);
+	bool save_checkpoint(InputFile *input, const char *path);
+	bool load_checkpoint(InputFile *input, const char *path);
+	unsigned long long int get_total_cost();
+	unsigned long int get_faults();
+
+	Frame* allocate_from_free_list();
+	template <class PagerType, bool extended>
+	Frame* get_frame(int page_number);
+	unsigned long long int get_time();
+	void wait_io(unsigned long int transfer);
+	void retire_writeback(unsigned long long int now);
+	void wait_writeback();
+	template <class PagerType, bool O_trace>
+	void run_kswapd();
+	void free_frame(Frame *frame);
+	Frame* reserve_frame(int page_number);
+	void populate_huge(Frame *frame);
+	void break_reservation(int c);
+	void release_reservations(int process_id);
+	template <bool O_trace>
+	void load_page(Frame *frame, PTE *pte, int page_number, bool copy);
+	template <bool O_trace>
+	void unmap_frame(Frame *frame);
+	template <bool O_trace>
+	void unmap_pte(int process_id, int page_number, PTE *pte, bool page_out);
+
+	void remove_mapping(Frame *frame, int process_id, int page_number);
+	void fork_process(int child);
+	void exec_process(int program);
+	void exit_process();
+	void release_pages(int process_id);
+
+	void trace(char kind, char cmd = 0, int num = 0, uint64_t arg = 0) {
+		/*
+			Function Name: trace
+			Arguments:
+				char kind: TRACE_* of line of O output
+				char cmd, int num, uint64_t arg: fields of TraceEvent as per kind
+			Returns: void
+			Description: emits a line of O output, formatted right away or handed to the 			format stage of a pipelined simulation
+		*/
+		TraceEvent event = {kind, cmd, num, arg};
+		if(event_ring == NULL) {
+			format_event(out, event);
+			return;
+		}
+		if(event_count == PIPELINE_BATCH_SIZE) push_events();
+		event_batch[event_count++] = event;
+	}
+	void print_page_table(int process_id);
+	void print_frame_table();
+	void print_age();
+};
+
+#endif
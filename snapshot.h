@@ -0,0 +1,97 @@
+/*
+	Module Name: snapshot.h
+	Description: Defines Snapshot, a compact binary image of the state of a simulation. 		Every stateful class has a state() method that passes each of its members to 		Snapshot::field(), which either writes or reads it. So saving and loading go through 		the same code and can not get out of step.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#define SNAPSHOT_MAGIC 0x53554d4d //"MMUS" when read as bytes
+#define SNAPSHOT_VERSION 6
+
+class Snapshot {
+	/*
+		Class Name: Snapshot
+		Description: transfers members between a simulation and a snapshot file. Plain 		members are copied as they are in memory, containers as their size followed by their 		elements. Snapshots are only read by the binary that wrote them.
+	*/
+private:
+	FILE *file; //snapshot file, opened for reading or writing
+
+public:
+	bool loading; //whether members are read from the file, written to it otherwise
+	bool failed; //whether a read or write fell short, later fields are skipped
+
+	Snapshot(FILE *file, bool loading) {
+		this->file = file;
+		this->loading = loading;
+		failed = false;
+	}
+
+	void bytes(void *data, size_t size) {
+		/*
+			Function Name: bytes
+			Arguments:
+				void *data: memory to be written or read into
+				size_t size: number of bytes
+			Returns: void
+		*/
+		if(failed || size == 0) return;
+		size_t done = loading ? fread(data, 1, size, file) : fwrite(data, 1, size, file);
+		if(done != size) failed = true;
+	}
+
+	template <class T>
+	void field(T &value) {
+		bytes(&value, sizeof(T));
+	}
+
+	uint64_t length(uint64_t size) {
+		/*
+			Function Name: length
+			Arguments:
+				uint64_t size: number of elements of container being written
+			Returns: uint64_t - number of elements of container, 0 if snapshot is broken
+		*/
+		field(size);
+		return failed ? 0 : size;
+	}
+
+	template <class T>
+	void field(std::vector<T> &values) {
+		uint64_t size = length(values.size());
+		if(loading) values.resize(size);
+		if(size > 0) bytes(&values[0], sizeof(T)*size);
+	}
+
+	void field(std::vector<bool> &values) {
+		uint64_t size = length(values.size());
+		if(loading) values.resize(size);
+		for(uint64_t i = 0; i < size; i++) {
+			char bit = values[i];
+			field(bit);
+			values[i] = bit;
+		}
+	}
+
+	void field(std::set<int> &values) {
+		std::vector<int> elements(values.begin(), values.end());
+		field(elements);
+		if(loading) values = std::set<int>(elements.begin(), elements.end());
+	}
+
+	void field(std::unordered_map<uint64_t, int> &values) {
+		std::vector<std::pair<uint64_t, int> > pairs(values.begin(), values.end());
+		field(pairs);
+		if(loading) {
+			values.clear();
+			values.insert(pairs.begin(), pairs.end());
+		}
+	}
+};
+
+#endif
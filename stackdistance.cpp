@@ -0,0 +1,425 @@
+/*
+	Module Name: stackdistance.cpp
+	Description: Computes miss curves of LRU and OPT for every memory size from 1 to a maximum 		in a single simulation-free pass over input file (Mattson stack algorithms). Curves are 		computed for all processes sharing memory and for every process on its own. Also 		computes the next use of every reference for OPT, both curves and pager.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "readinput.h"
+
+
+/*************************** imported from readinput.cpp ***************************/
+extern void initPageTable(Process *process);
+extern void clearPageTable(Process *process);
+
+
+#define EMPTY_SLOT UINT64_MAX //slot without a page in LRU stack
+
+
+class LRUStack {
+	/*
+		Class Name: LRUStack
+		Description: computes the LRU stack distance of every reference. Every page has a 		marker at the time slot of its last reference, the distance of a reference is the 		number of markers at or after the previous reference of its page. Markers are kept in 		a FenwickTree, so a reference costs O(log pages). Slots are renumbered when they run 		out.
+	*/
+private:
+	FenwickTree markers; //1 at the slot of last reference of every page
+	std::unordered_map<uint64_t, int> last_slot; //slot of last reference of every page
+	std::vector<uint64_t> slot_page; //page referenced at slot, EMPTY_SLOT if superseded
+	int now; //next free slot
+
+	void compact() {
+		/*
+			Function Name: compact
+			Returns: void
+			Description: renumbers the live slots from 0 keeping their order and makes room for 			as many new ones
+		*/
+		std::vector<uint64_t> live;
+		for(int i = 0; i < now; i++) {
+			if(slot_page[i] != EMPTY_SLOT) live.push_back(slot_page[i]);
+		}
+		int capacity = 2*live.size() + 1024;
+		markers.resize(capacity);
+		slot_page.assign(capacity, EMPTY_SLOT);
+		for(int i = 0; i < (int)live.size(); i++) {
+			markers.add(i, 1);
+			slot_page[i] = live[i];
+			last_slot[live[i]] = i;
+		}
+		now = live.size();
+	}
+
+public:
+	int max_frames; //largest memory size of curve
+	std::vector<unsigned long int> histogram; //references by distance, max_frames+1 counts longer ones
+	unsigned long int cold; //first references of pages
+	unsigned long int references; //total number of references
+
+	LRUStack(int max_frames) {
+		this->max_frames = max_frames;
+		histogram.assign(max_frames + 2, 0);
+		cold = references = 0;
+		now = 0;
+		compact();
+	}
+
+	void reference(uint64_t page) {
+		/*
+			Function Name: reference
+			Arguments:
+				uint64_t page: referenced page, unique across processes
+			Returns: void
+			Description: records the stack distance of the reference and moves the page to top
+		*/
+		references++;
+		if(now == markers.size()) compact();
+
+		std::unordered_map<uint64_t, int>::iterator it = last_slot.find(page);
+		if(it == last_slot.end()) {
+			cold++;
+			last_slot[page] = now;
+		} else {
+			int slot = it->second;
+			unsigned long int distance = markers.total() - markers.prefix_sum(slot);
+			histogram[distance > (unsigned long int)max_frames ? max_frames + 1 : distance]++;
+			markers.add(slot, -1);
+			slot_page[slot] = EMPTY_SLOT;
+			it->second = now;
+		}
+		markers.add(now, 1);
+		slot_page[now] = page;
+		now++;
+	}
+};
+
+
+class OPTStack {
+	/*
+		Class Name: OPTStack
+		Description: computes the OPT stack distance of every reference. The stack is ordered 		so that its top k pages are the content of an OPT managed memory of k frames. On a 		reference the displaced pages sink level by level, at every level the page used next 		stays and the other one sinks further. Only the top max_frames levels are kept.
+	*/
+private:
+	std::vector<uint64_t> stack; //pages, top first
+	std::vector<uint64_t> next_use; //next use of page at same level
+
+public:
+	int max_frames; //largest memory size of curve
+	std::vector<unsigned long int> histogram; //references by distance, max_frames+1 counts longer ones
+	unsigned long int cold; //references to pages that are not in stack, they miss in every memory size
+	unsigned long int references; //total number of references
+
+	OPTStack(int max_frames) {
+		this->max_frames = max_frames;
+		histogram.assign(max_frames + 2, 0);
+		cold = references = 0;
+	}
+
+	void reference(uint64_t page, uint64_t next) {
+		/*
+			Function Name: reference
+			Arguments:
+				uint64_t page: referenced page, unique across processes
+				uint64_t next: index of next reference to page, NO_NEXT_USE if there is none
+			Returns: void
+			Description: records the stack distance of the reference and updates the stack
+		*/
+		references++;
+		if(!stack.empty() && stack[0] == page) {
+			histogram[1]++;
+			next_use[0] = next;
+			return;
+		}
+
+		//sink the pages above the referenced one
+		uint64_t carry = stack.empty() ? EMPTY_SLOT : stack[0];
+		uint64_t carry_next = stack.empty() ? 0 : next_use[0];
+		int depth = stack.size();
+		for(int i = 1; i < (int)stack.size(); i++) {
+			if(stack[i] == page) {
+				depth = i;
+				break;
+			}
+			if(next_use[i] > carry_next) {
+				uint64_t page_i = stack[i];
+				uint64_t next_i = next_use[i];
+				stack[i] = carry;
+				next_use[i] = carry_next;
+				carry = page_i;
+				carry_next = next_i;
+			}
+		}
+
+		if(depth < (int)stack.size()) {
+			//referenced page leaves its level to the last sinking page
+			histogram[depth + 1 > max_frames ? max_frames + 1 : depth + 1]++;
+			stack[depth] = carry;
+			next_use[depth] = carry_next;
+		} else {
+			cold++;
+			if(carry != EMPTY_SLOT && (int)stack.size() < max_frames) {
+				stack.push_back(carry);
+				next_use.push_back(carry_next);
+			}
+			if(stack.empty()) {
+				stack.push_back(page);
+				next_use.push_back(next);
+			}
+		}
+		stack[0] = page;
+		next_use[0] = next;
+	}
+};
+
+
+unsigned long int misses(std::vector<unsigned long int> &histogram, unsigned long int cold, int frames, std::vector<unsigned long int> &longer) {
+	/*
+		Function Name: misses
+		Arguments:
+			std::vector<unsigned long int> &histogram: references by stack distance
+			unsigned long int cold: references that miss in every memory size
+			int frames: memory size
+			std::vector<unsigned long int> &longer: longer[d] is sum of histogram above d, filled on first call
+		Returns: unsigned long int - number of misses with frames frames
+	*/
+	if(longer.empty()) {
+		longer.assign(histogram.size() + 1, 0);
+		for(int d = histogram.size() - 1; d >= 0; d--) {
+			longer[d] = longer[d + 1] + histogram[d];
+		}
+	}
+	return cold + longer[frames + 1];
+}
+
+
+template <class Stack>
+void print_curve(const char *name, Stack *global, std::vector<Stack*> &local) {
+	/*
+		Function Name: print_curve
+		Arguments:
+			const char *name: name of algorithm
+			Stack *global: stack of all processes sharing memory
+			std::vector<Stack*> &local: stack of every process on its own
+		Returns: void
+		Description: prints number of misses and miss ratio for every memory size, followed by 		misses of every process given the same memory on its own
+	*/
+	std::vector<unsigned long int> longer;
+	std::vector<std::vector<unsigned long int> > local_longer(local.size());
+
+	printf("%s references=%lu\n", name, global->references);
+	printf("frames misses ratio");
+	for(int i = 0; i < (int)local.size(); i++) printf(" PROC[%d]", i);
+	printf("\n");
+
+	for(int frames = 1; frames <= global->max_frames; frames++) {
+		unsigned long int m = misses(global->histogram, global->cold, frames, longer);
+		printf("%d %lu %.6f", frames, m, global->references ? (double)m/global->references : 0.0);
+		for(int i = 0; i < (int)local.size(); i++) {
+			printf(" %lu", misses(local[i]->histogram, local[i]->cold, frames, local_longer[i]));
+		}
+		printf("\n");
+	}
+}
+
+
+void change_space(InputFile *input, Process **spaces, int curr_proc, Command &command) {
+	/*
+		Function Name: change_space
+		Arguments:
+			InputFile *input: input file whose processes are exec'd
+			Process **spaces: processes with their page tables
+			int curr_proc: current context
+			Command &command: fork, exec or exit command
+		Returns: void
+		Description: replaces the VMAs of the address space the command changes, as simulate() 		does. Pages shared after a fork are counted as pages of every process mapping them, 		and a page keeps its identity across exec and exit.
+	*/
+	int target = (command.cmd == 'f') ? command.num : curr_proc;
+	if(target < 0 || target >= input->num_processes) return;
+	if(command.cmd == 'e' && (command.num < 0 || command.num >= input->num_processes)) return;
+	if(command.cmd == 'f' && target == curr_proc) return;
+
+	clearPageTable(spaces[target]);
+	if(command.cmd == 'f') spaces[target]->vmas = spaces[curr_proc]->vmas;
+	else if(command.cmd == 'e') spaces[target]->vmas = input->processes[command.num]->vmas;
+	initPageTable(spaces[target]);
+}
+
+
+bool next_reference(InputFile *input, Process **spaces, int *curr_proc, bool *started, uint64_t *page, unsigned long int *space_changes) {
+	/*
+		Function Name: next_reference
+		Arguments:
+			InputFile *input: input file references are read from
+			Process **spaces: processes with their page tables
+			int *curr_proc: current context, updated on context switches
+			bool *started: whether the first command, always a context switch, was seen
+			uint64_t *page: set to the referenced page, unique across processes
+			unsigned long int *space_changes: incremented for every fork, exec and exit
+		Returns: bool - false if input file is exhausted
+		Description: returns the next reference that pages memory in simulate(). Context 		switches, fork, exec, exit and SEGV references are skipped. SEGPROT references are kept as simulate() 		maps the page before it detects the protection fault.
+	*/
+	Command command;
+	while(input->getNextCommand(&command)) {
+		if(!*started || command.cmd == 'c') {
+			*started = true;
+			*curr_proc = command.num;
+			continue;
+		}
+		if(command.cmd == 'f' || command.cmd == 'e' || command.cmd == 'x') {
+			change_space(input, spaces, *curr_proc, command);
+			(*space_changes)++;
+			continue;
+		}
+		if(!spaces[*curr_proc]->page_table.lookup(command.num)->valid) continue;
+		*page = ((uint64_t)*curr_proc << 32) | (uint32_t)command.num;
+		return true;
+	}
+	return false;
+}
+
+
+Process** create_spaces(InputFile *input) {
+	/*
+		Function Name: create_spaces
+		Arguments:
+			InputFile *input: input file whose processes are copied
+		Returns: Process** - processes with page tables populated from their VMAs
+		Description: page tables decide which references are valid
+	*/
+	Process **spaces = (Process**)malloc(sizeof(Process*)*input->num_processes);
+	for(int i = 0; i < input->num_processes; i++) {
+		spaces[i] = new Process(i, input->vpage_bits);
+		spaces[i]->vmas = input->processes[i]->vmas;
+		initPageTable(spaces[i]);
+	}
+	return spaces;
+}
+
+
+void delete_spaces(Process **spaces, int num_processes) {
+	for(int i = 0; i < num_processes; i++) {
+		delete spaces[i];
+	}
+	free(spaces);
+}
+
+
+void warn_space_changes(unsigned long int space_changes) {
+	/*
+		Function Name: warn_space_changes
+		Arguments:
+			unsigned long int space_changes: fork, exec and exit commands of input file
+		Returns: void
+		Description: simulate() shares pages between processes after a fork, OPT and the 		miss curves do not, so their numbers for such an input are not exact
+	*/
+	if(space_changes > 0) {
+		fprintf(stderr, "warning: input has %lu fork, exec or exit commands, OPT and the miss curves count a page shared after a fork as a page of every process mapping it\n", space_changes);
+	}
+}
+
+
+unsigned long int compute_next_uses(InputFile *input, std::vector<uint64_t> &next_use) {
+	/*
+		Function Name: compute_next_uses
+		Arguments:
+			InputFile *input: input file to be read
+			std::vector<uint64_t> &next_use: filled with index of next reference to same page, 			NO_NEXT_USE if there is none, for every reference
+		Returns: unsigned long int - number of fork, exec and exit commands of input file
+		Description: makes a pass over input file and rewinds it. References are counted as 		in next_reference(), which is also how often simulate() calls reference_frame().
+	*/
+	Process **spaces = create_spaces(input);
+	std::unordered_map<uint64_t, uint64_t> last_use; //index of last reference to every page
+
+	int curr_proc = 0;
+	bool started = false;
+	uint64_t page;
+	uint64_t index = 0;
+	unsigned long int space_changes = 0;
+	next_use.clear();
+	while(next_reference(input, spaces, &curr_proc, &started, &page, &space_changes)) {
+		std::unordered_map<uint64_t, uint64_t>::iterator it = last_use.find(page);
+		if(it != last_use.end()) {
+			next_use[it->second] = index;
+			it->second = index;
+		} else {
+			last_use[page] = index;
+		}
+		next_use.push_back(NO_NEXT_USE);
+		index++;
+	}
+
+	input->rewindInput();
+	delete_spaces(spaces, input->num_processes);
+	return space_changes;
+}
+
+
+std::vector<uint64_t>* get_next_uses(InputFile *input) {
+	/*
+		Function Name: get_next_uses
+		Arguments:
+			InputFile *input: input file whose references are looked at
+		Returns: std::vector<uint64_t>* - next use of every reference, computed on first call 		and shared by all OPT pagers of input file
+		Description: must be called before commands are read, as it reads the whole input 		file once. Warns once if input file has fork, exec or exit commands.
+	*/
+	if(input->next_uses == NULL) {
+		input->next_uses = new std::vector<uint64_t>();
+		warn_space_changes(compute_next_uses(input, *input->next_uses));
+	}
+	return input->next_uses;
+}
+
+
+void run_stack_distance(InputFile *input, char *kinds, int max_frames) {
+	/*
+		Function Name: run_stack_distance
+		Arguments:
+			InputFile *input: input file to be read
+			char *kinds: 'l' for LRU curve, 'o' for OPT curve, or both
+			int max_frames: largest memory size of curves
+		Returns: void
+		Description: computes and prints the requested miss curves. OPT needs the next uses 		first, so it takes two passes over input file. Curves of an input with fork, exec or 		exit are not exact, a warning is printed to stderr.
+	*/
+	bool lru = (strchr(kinds, 'l') != NULL);
+	bool opt = (strchr(kinds, 'o') != NULL);
+
+	std::vector<uint64_t> *next_use = opt ? get_next_uses(input) : NULL;
+	Process **spaces = create_spaces(input);
+
+	LRUStack global_lru(max_frames);
+	OPTStack global_opt(max_frames);
+	std::vector<LRUStack*> local_lru;
+	std::vector<OPTStack*> local_opt;
+	for(int i = 0; i < input->num_processes; i++) {
+		local_lru.push_back(new LRUStack(max_frames));
+		local_opt.push_back(new OPTStack(max_frames));
+	}
+
+	int curr_proc = 0;
+	bool started = false;
+	uint64_t page;
+	uint64_t index = 0;
+	unsigned long int space_changes = 0;
+	while(next_reference(input, spaces, &curr_proc, &started, &page, &space_changes)) {
+		if(lru) {
+			global_lru.reference(page);
+			local_lru[curr_proc]->reference(page);
+		}
+		if(opt) {
+			global_opt.reference(page, (*next_use)[index]);
+			local_opt[curr_proc]->reference(page, (*next_use)[index]);
+		}
+		index++;
+	}
+
+	//get_next_uses() has already warned for OPT
+	if(!opt) warn_space_changes(space_changes);
+	if(lru) print_curve("LRU", &global_lru, local_lru);
+	if(opt) print_curve("OPT", &global_opt, local_opt);
+
+	for(int i = 0; i < input->num_processes; i++) {
+		delete local_lru[i];
+		delete local_opt[i];
+	}
+	delete_spaces(spaces, input->num_processes);
+}
@@ -0,0 +1,336 @@
+/*
+	Module Name: sweep.cpp
+	Description: Runs a sweep, i.e. one simulation for every combination of algorithm and 		memory size. Input file is parsed once, decoded commands are handed in batches to 		worker threads that feed them to their simulators. Local replacement is run the same 		way with one simulation per process, each worker feeds its simulators only the 		commands of their process.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "simulator.h"
+
+#define SWEEP_BATCH_SIZE 65536 //commands handed to workers at once
+
+
+class SweepBatches {
+	/*
+		Class Name: SweepBatches
+		Description: hands batches of commands from the reading thread to all workers. A 		batch is published once every worker is done with the previous one, so the reading 		thread can fill the next batch while workers are busy.
+	*/
+private:
+	std::mutex lock;
+	std::condition_variable published; //signalled when a batch is published
+	std::condition_variable finished; //signalled when all workers are done with a batch
+	unsigned long int generation; //number of batches published
+	int pending; //workers not yet done with current batch
+	int num_workers; //total number of workers
+
+public:
+	Command *batch; //current batch
+	int batch_size; //commands in current batch, 0 once input is exhausted
+
+	SweepBatches(int num_workers) {
+		generation = 0;
+		pending = 0;
+		batch = NULL;
+		batch_size = 0;
+		this->num_workers = num_workers;
+	}
+
+	void publish(Command *commands, int size) {
+		/*
+			Function Name: publish
+			Arguments:
+				Command *commands: batch to be handed to workers
+				int size: commands in batch, 0 to stop workers
+			Returns: void
+			Description: waits for workers to finish current batch and publishes the next one
+		*/
+		std::unique_lock<std::mutex> guard(lock);
+		while(pending != 0) finished.wait(guard);
+		batch = commands;
+		batch_size = size;
+		pending = num_workers;
+		generation++;
+		published.notify_all();
+	}
+
+	unsigned long int next(unsigned long int seen) {
+		/*
+			Function Name: next
+			Arguments:
+				unsigned long int seen: generation of last batch processed by the worker
+			Returns: unsigned long int - generation of newly published batch
+			Description: waits until a batch newer than seen is published
+		*/
+		std::unique_lock<std::mutex> guard(lock);
+		while(generation == seen) published.wait(guard);
+		return generation;
+	}
+
+	void done() {
+		/*
+			Function Name: done
+			Returns: void
+			Description: called by a worker once it is done with current batch
+		*/
+		std::unique_lock<std::mutex> guard(lock);
+		if(--pending == 0) finished.notify_all();
+	}
+};
+
+
+void sweep_worker(SweepBatches *batches, std::vector<Simulator*> simulators) {
+	/*
+		Function Name: sweep_worker
+		Arguments:
+			SweepBatches *batches: source of command batches
+			std::vector<Simulator*> simulators: simulators owned by this worker
+		Returns: void
+		Description: feeds every published batch to all simulators of the worker
+	*/
+	unsigned long int seen = 0;
+	while(true) {
+		seen = batches->next(seen);
+		int size = batches->batch_size;
+		Command *batch = batches->batch;
+
+		for(int s = 0; s < (int)simulators.size(); s++) {
+			simulators[s]->simulate_commands(batch, size);
+		}
+		batches->done();
+		if(size == 0) return;
+	}
+}
+
+
+void run_sweep(InputFile *input, SimulatorConfig config, char *algos, std::vector<int> &frame_counts, int num_threads) {
+	/*
+		Function Name: run_sweep
+		Arguments:
+			InputFile *input: input file to be simulated
+			SimulatorConfig config: options shared by all simulations
+			char *algos: algorithms to be simulated
+			std::vector<int> &frame_counts: memory sizes to be simulated
+			int num_threads: number of worker threads, 0 for one per hardware thread
+		Returns: void
+		Description: simulates every combination of algorithm and memory size in one pass 		over input file and prints the summary of each
+	*/
+
+	//per instruction output of many simulations can not be interleaved
+	if(config.O_flag || config.x_flag || config.f_flag) {
+		fprintf(stderr, "options O, x and f are ignored in a sweep\n");
+		config.O_flag = config.x_flag = config.f_flag = false;
+	}
+
+	std::vector<Simulator*> simulators;
+	for(int a = 0; a < (int)strlen(algos); a++) {
+		for(int f = 0; f < (int)frame_counts.size(); f++) {
+			config.algo = algos[a];
+			config.frame_limit = frame_counts[f];
+			simulators.push_back(new Simulator(config, input));
+		}
+	}
+
+	if(num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+	if(num_threads <= 0) num_threads = 1;
+	if(num_threads > (int)simulators.size()) num_threads = simulators.size();
+
+	//simulators are dealt to workers round robin
+	SweepBatches batches(num_threads);
+	std::vector<std::thread> workers;
+	for(int t = 0; t < num_threads; t++) {
+		std::vector<Simulator*> owned;
+		for(int s = t; s < (int)simulators.size(); s += num_threads) {
+			owned.push_back(simulators[s]);
+		}
+		workers.push_back(std::thread(sweep_worker, &batches, owned));
+	}
+
+	//fill one buffer while workers process the other
+	std::vector<Command> buffers[2];
+	buffers[0].resize(SWEEP_BATCH_SIZE);
+	buffers[1].resize(SWEEP_BATCH_SIZE);
+	int curr = 0;
+	while(true) {
+		int size = 0;
+		while(size < SWEEP_BATCH_SIZE && input->getNextCommand(&buffers[curr][size])) size++;
+		if(size == 0) break;
+		batches.publish(&buffers[curr][0], size);
+		curr = 1 - curr;
+	}
+	batches.publish(NULL, 0);
+	for(int t = 0; t < num_threads; t++) {
+		workers[t].join();
+	}
+
+	//print summary of every simulation in order of options
+	for(int s = 0; s < (int)simulators.size(); s++) {
+		OutputBuffer &out = simulators[s]->out;
+		out.put("==> algorithm ");
+		out.put(simulators[s]->algo);
+		out.put(" frames ");
+		out.put_int(simulators[s]->frame_limit);
+		out.put('\n');
+		simulators[s]->print_summary();
+		delete simulators[s];
+	}
+}
+
+
+bool owns_partition(int process, int num_partitions, int num_workers, int worker) {
+	/*
+		Function Name: owns_partition
+		Arguments:
+			int process: process whose partition is looked up
+			int num_partitions: total number of partitions
+			int num_workers: total number of workers
+			int worker: index of worker
+		Returns: bool - whether worker simulates the partition of process
+		Description: partitions are dealt to workers round robin
+	*/
+	return process >= 0 && process < num_partitions && process % num_workers == worker;
+}
+
+
+void local_worker(SweepBatches *batches, std::vector<Simulator*> *partitions, int num_workers, int worker) {
+	/*
+		Function Name: local_worker
+		Arguments:
+			SweepBatches *batches: source of command batches
+			std::vector<Simulator*> *partitions: simulator of every process
+			int num_workers: total number of workers
+			int worker: index of this worker
+		Returns: void
+		Description: splits every published batch at context switches and feeds the runs of 		commands of its processes to their partitions. A run starts with its context switch, 		so every partition starts with a context switch as a simulation does.
+	*/
+	int num_partitions = partitions->size();
+	int curr_proc = -1; //process of current run, carried over from batch to batch
+	bool started = false; //whether the first command, always a context switch, was seen
+	unsigned long int seen = 0;
+	while(true) {
+		seen = batches->next(seen);
+		int size = batches->batch_size;
+		Command *batch = batches->batch;
+
+		int start = 0; //first command of current run
+		for(int i = 0; i < size; i++) {
+			if(started && batch[i].cmd != 'c') continue;
+			if(owns_partition(curr_proc, num_partitions, num_workers, worker)) {
+				(*partitions)[curr_proc]->simulate_commands(batch + start, i - start);
+			}
+			started = true;
+			curr_proc = batch[i].num;
+			start = i;
+		}
+		if(owns_partition(curr_proc, num_partitions, num_workers, worker)) {
+			(*partitions)[curr_proc]->simulate_commands(batch + start, size - start);
+		}
+		batches->done();
+		if(size == 0) return;
+	}
+}
+
+
+void run_local(InputFile *input, SimulatorConfig config, std::vector<int> &quotas, int num_threads) {
+	/*
+		Function Name: run_local
+		Arguments:
+			InputFile *input: input file to be simulated
+			SimulatorConfig config: options of simulation
+			std::vector<int> &quotas: frames of every process, the last one is used for processes 			without a quota of their own
+			int num_threads: number of worker threads, 0 for one per hardware thread
+		Returns: void
+		Description: simulates local replacement, every process only replaces pages in its 		own frames. As processes do not interact, every process is simulated by a simulator 		of its own with its own pager and position in random numbers, in parallel to the 		others. The summary is merged in process order, results do not depend on the number 		of threads.
+	*/
+
+	//per instruction output of many simulations can not be interleaved
+	if(config.O_flag || config.x_flag || config.f_flag) {
+		fprintf(stderr, "options O, x and f are ignored in local replacement\n");
+		config.O_flag = config.x_flag = config.f_flag = false;
+	}
+
+	std::vector<Simulator*> partitions;
+	for(int i = 0; i < input->num_processes; i++) {
+		config.frame_limit = quotas[(i < (int)quotas.size()) ? i : quotas.size() - 1];
+		config.partition = i;
+		partitions.push_back(new Simulator(config, input));
+	}
+	if(partitions.empty()) return;
+
+	if(num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+	if(num_threads <= 0) num_threads = 1;
+	if(num_threads > (int)partitions.size()) num_threads = partitions.size();
+
+	SweepBatches batches(num_threads);
+	std::vector<std::thread> workers;
+	for(int t = 0; t < num_threads; t++) {
+		workers.push_back(std::thread(local_worker, &batches, &partitions, num_threads, t));
+	}
+
+	//fill one buffer while workers process the other
+	std::vector<Command> buffers[2];
+	buffers[0].resize(SWEEP_BATCH_SIZE);
+	buffers[1].resize(SWEEP_BATCH_SIZE);
+	int curr = 0;
+	while(true) {
+		int size = 0;
+		while(size < SWEEP_BATCH_SIZE && input->getNextCommand(&buffers[curr][size])) size++;
+		if(size == 0) break;
+		batches.publish(&buffers[curr][0], size);
+		curr = 1 - curr;
+	}
+	batches.publish(NULL, 0);
+	for(int t = 0; t < num_threads; t++) {
+		workers[t].join();
+	}
+
+	//partitions write to the same file, each one is flushed before the next one writes
+	int num_partitions = partitions.size();
+	if(config.P_flag) {
+		for(int i = 0; i < num_partitions; i++) {
+			partitions[i]->print_page_table(i);
+			partitions[i]->out.flush();
+		}
+	}
+	if(config.F_flag) {
+		for(int i = 0; i < num_partitions; i++) {
+			partitions[i]->print_frame_table();
+			partitions[i]->out.flush();
+		}
+	}
+	if(config.S_flag) {
+		//every process has the counters of exec and exit once any partition saw one
+		bool sharing = false;
+		for(int i = 0; i < num_partitions; i++) {
+			sharing = sharing || partitions[i]->sharing;
+		}
+
+		unsigned long int ctx_switches = 0, instructions = 0;
+		unsigned long long int cost = 0;
+		for(int i = 0; i < num_partitions; i++) {
+			partitions[i]->processes[i]->print_stats(partitions[i]->out, partitions[i]->tlb != NULL, sharing, partitions[i]->huge != NULL);
+			partitions[i]->out.flush();
+
+			//first command of a partition is not counted by it, but is by a simulation
+			if(partitions[i]->started) instructions += partitions[i]->instr_num + 1;
+			ctx_switches += partitions[i]->ctx_switches;
+			cost += partitions[i]->get_total_cost();
+		}
+
+		OutputBuffer &out = partitions[0]->out;
+		out.put("TOTALCOST ");
+		out.put_uint(ctx_switches);
+		out.put(' ');
+		out.put_uint(instructions);
+		out.put(' ');
+		out.put_uint(cost);
+		out.put('\n');
+		out.flush();
+	}
+
+	for(int i = 0; i < num_partitions; i++) {
+		delete partitions[i];
+	}
+}
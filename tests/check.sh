@@ -0,0 +1,13 @@
+#!/bin/bash
+# usage: tests/check.sh [mmu binary]
+# runs every algorithm of the first version of mmu on the text traces of tests/ and compares
+# the output with tests/expected/, which was printed by that first version
+D=$(dirname "$0"); B=$(realpath "${1:-$D/../mmu}"); cd "$D"; fail=0
+for i in 0 4; do for a in f s r n c a; do for f in 4 32; do
+	$B -a$a -f$f -oOPFS in$i.txt rfile | cmp -s - expected/$i.$a.$f.OPFS || { echo "MISMATCH in$i.txt -a$a -f$f"; fail=1; }
+done; done; done
+for a in f s r n c a; do
+	$B -a$a -f7 -oOPFSxf in4.txt rfile | cmp -s - expected/4.$a.7.all || { echo "MISMATCH in4.txt -a$a -f7 -oOPFSxf"; fail=1; }
+done
+[ $fail = 0 ] && echo "ALL MATCH"
+exit $fail
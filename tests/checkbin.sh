@@ -0,0 +1,17 @@
+#!/bin/bash
+# usage: tests/checkbin.sh [mmu binary] [traceconv binary]
+# converts the text traces of tests/ to binary traces and checks that mmu prints the same
+# output for them as tests/expected/ has for the text traces
+D=$(dirname "$0"); B=$(realpath "${1:-$D/../mmu}"); C=$(realpath "${2:-$D/../traceconv}"); cd "$D"; fail=0
+T=$(mktemp -d); trap 'rm -rf "$T"' EXIT
+for i in 0 4; do
+	$C in$i.txt $T/in$i.bin >/dev/null || { echo "traceconv failed on in$i.txt"; exit 1; }
+	for a in f s r n c a; do for f in 4 32; do
+		$B -a$a -f$f -oOPFS $T/in$i.bin rfile | cmp -s - expected/$i.$a.$f.OPFS || { echo "BIN MISMATCH in$i.txt -a$a -f$f"; fail=1; }
+	done; done
+done
+for a in f s r n c a; do
+	$B -a$a -f7 -oOPFSxf $T/in4.bin rfile | cmp -s - expected/4.$a.7.all || { echo "BIN MISMATCH in4.txt -a$a -f7 -oOPFSxf"; fail=1; }
+done
+[ $fail = 0 ] && echo "BIN MATCH"
+exit $fail
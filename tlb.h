@@ -0,0 +1,306 @@
+/*
+	Module Name: tlb.h
+	Description: Defines TLBConfig and TLB, a model of a two level translation lookaside buffer 		in front of the page table. Entries are tagged with the process id as ASID, or the 		whole TLB is flushed on every context switch. The entry of a page is invalidated when 		the page is unmapped. An entry caches the PTE of its page, so a hit also saves the 		simulator the walk through the page table. A huge page has a single entry for all its 		pages, which caches the PTE of its first page.
+*/
+#include <stdint.h>
+#include <vector>
+#include "datastructures.h"
+
+#ifndef TLB_H
+#define TLB_H
+
+#define TLB_HUGE_TAG (1ull << 31) //set in key of entry of a huge page, page numbers are narrower
+
+struct TLBConfig {
+	/*
+		Struct Name: TLBConfig
+		Description: defines the geometry of a TLB, 0 L1 entries for no TLB
+	*/
+	int l1_entries, l1_ways; //size and associativity of L1
+	int l2_entries, l2_ways; //size and associativity of L2, 0 entries for no L2
+	bool flush_on_switch; //whether context switches flush the TLB instead of entries having ASIDs
+};
+
+class TLBLevel {
+	/*
+		Class Name: TLBLevel
+		Description: one set associative level of a TLB. Sets are indexed by the low bits 		of the page number and replace their least recently used entry. The ways of a set 		are contiguous, so a lookup touches a single cache line for up to 8 ways.
+	*/
+private:
+	int sets; //number of sets, a power of 2
+	int ways; //entries per set
+	std::vector<uint64_t> keys; //ASID and page of every entry, 0 if empty
+	std::vector<PTE*> ptes; //PTE cached by every entry
+	std::vector<uint64_t> stamps; //time of last use of every entry
+	uint64_t clock; //time of last use
+
+public:
+	TLBLevel() {
+		sets = ways = 0;
+		clock = 0;
+	}
+
+	void resize(int entries, int ways) {
+		/*
+			Function Name: resize
+			Arguments:
+				int entries: number of entries, a power of 2 times ways
+				int ways: entries per set
+			Returns: void
+		*/
+		this->ways = ways;
+		sets = (ways > 0) ? entries/ways : 0;
+		keys.assign(entries, 0);
+		ptes.assign(entries, (PTE*)NULL);
+		stamps.assign(entries, 0);
+		clock = 0;
+	}
+
+	int size() {
+		return keys.size();
+	}
+
+	static uint64_t key(int asid, unsigned int page) {
+		/*
+			Function Name: key
+			Arguments:
+				int asid: process id
+				unsigned int page: page number
+			Returns: uint64_t - tag of entry of page, never 0
+		*/
+		return ((uint64_t)(asid + 1) << 32) | page;
+	}
+
+	PTE* lookup(uint64_t tag, unsigned int page) {
+		/*
+			Function Name: lookup
+			Arguments:
+				uint64_t tag: key() of page
+				unsigned int page: page number
+			Returns: PTE* - PTE of page, NULL if it has no entry
+		*/
+		int base = (page & (sets - 1))*ways;
+		for(int w = 0; w < ways; w++) {
+			if(keys[base + w] == tag) {
+				stamps[base + w] = ++clock;
+				return ptes[base + w];
+			}
+		}
+		return NULL;
+	}
+
+	void insert(uint64_t tag, unsigned int page, PTE *pte) {
+		/*
+			Function Name: insert
+			Arguments:
+				uint64_t tag: key() of page
+				unsigned int page: page number, must not have an entry
+				PTE *pte: PTE of page
+			Returns: void
+			Description: replaces an empty or else the least recently used entry of the set
+		*/
+		int base = (page & (sets - 1))*ways;
+		int victim = base;
+		for(int w = 0; w < ways; w++) {
+			if(keys[base + w] == 0) {
+				victim = base + w;
+				break;
+			}
+			if(stamps[base + w] < stamps[victim]) victim = base + w;
+		}
+		keys[victim] = tag;
+		ptes[victim] = pte;
+		stamps[victim] = ++clock;
+	}
+
+	bool invalidate(uint64_t tag, unsigned int page) {
+		/*
+			Function Name: invalidate
+			Arguments:
+				uint64_t tag: key() of page
+				unsigned int page: page number
+			Returns: bool - whether page had an entry
+		*/
+		int base = (page & (sets - 1))*ways;
+		for(int w = 0; w < ways; w++) {
+			if(keys[base + w] == tag) {
+				keys[base + w] = 0;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void flush() {
+		keys.assign(keys.size(), 0);
+	}
+
+	void flush_asid(int asid) {
+		/*
+			Function Name: flush_asid
+			Arguments:
+				int asid: process whose entries are invalidated
+			Returns: void
+		*/
+		for(int i = 0; i < (int)keys.size(); i++) {
+			if((keys[i] >> 32) == (uint64_t)(asid + 1)) keys[i] = 0;
+		}
+	}
+
+	void state(Snapshot &snapshot, Process **processes, int huge_bits) {
+		/*
+			Function Name: state
+			Arguments:
+				Snapshot &snapshot: snapshot the state is saved to or loaded from
+				Process **processes: processes of simulation, PTEs of entries are looked up 				in their page tables on load
+				int huge_bits: log2 of pages per huge page
+			Returns: void
+		*/
+		snapshot.field(keys);
+		snapshot.field(stamps);
+		snapshot.field(clock);
+		if(!snapshot.loading || snapshot.failed) return;
+		for(int i = 0; i < (int)keys.size(); i++) {
+			if(keys[i] == 0) {
+				ptes[i] = NULL;
+				continue;
+			}
+			unsigned int page = (unsigned int)(keys[i] & ~TLB_HUGE_TAG);
+			if(keys[i] & TLB_HUGE_TAG) page <<= huge_bits;
+			ptes[i] = processes[(keys[i] >> 32) - 1]->page_table.lookup(page);
+		}
+	}
+};
+
+class TLB {
+	/*
+		Class Name: TLB
+		Description: L1 backed by an optional L2. A page found in L2 is copied to L1, a 		page that had to be walked is put in both. Both levels hold entries of base and huge 		pages, every level is searched for the entry of the page and then for the one of its 		huge page. Entries of huge pages are indexed by the number of the huge page.
+	*/
+private:
+	TLBLevel l1, l2;
+	int huge_bits; //log2 of pages per huge page, 0 for no huge pages
+
+	PTE* lookup_level(TLBLevel &level, int asid, unsigned int page, bool *huge) {
+		/*
+			Function Name: lookup_level
+			Arguments:
+				TLBLevel &level: level searched
+				int asid: process id
+				unsigned int page: page number
+				bool *huge: set to whether the entry of huge page of page was found
+			Returns: PTE* - PTE of page, NULL if level has no entry for it
+		*/
+		PTE *pte = level.lookup(TLBLevel::key(asid, page), page);
+		if(pte != NULL || huge_bits == 0) return pte;
+		unsigned int huge_page = page >> huge_bits;
+		pte = level.lookup(TLBLevel::key(asid, huge_page) | TLB_HUGE_TAG, huge_page);
+		if(pte == NULL) return NULL;
+		*huge = true;
+		return pte + (page & ((1u << huge_bits) - 1));
+	}
+
+	void insert_level(TLBLevel &level, int asid, unsigned int page, PTE *pte, bool huge) {
+		if(!huge) {
+			level.insert(TLBLevel::key(asid, page), page, pte);
+			return;
+		}
+		unsigned int huge_page = page >> huge_bits;
+		level.insert(TLBLevel::key(asid, huge_page) | TLB_HUGE_TAG, huge_page, pte - (page & ((1u << huge_bits) - 1)));
+	}
+
+public:
+	bool flush_on_switch; //whether context switches flush the TLB
+
+	TLB(TLBConfig config, int huge_bits) {
+		l1.resize(config.l1_entries, config.l1_ways);
+		l2.resize(config.l2_entries, config.l2_ways);
+		flush_on_switch = config.flush_on_switch;
+		this->huge_bits = huge_bits;
+	}
+
+	PTE* lookup(int asid, unsigned int page, int *level, bool *huge) {
+		/*
+			Function Name: lookup
+			Arguments:
+				int asid: process id
+				unsigned int page: page number
+				int *level: set to level the page was found in
+				bool *huge: set to whether it was found through the entry of its huge page
+			Returns: PTE* - PTE of page, NULL if it has to be walked
+		*/
+		*huge = false;
+		PTE *pte = lookup_level(l1, asid, page, huge);
+		if(pte != NULL) {
+			*level = 1;
+			return pte;
+		}
+		if(l2.size() == 0) return NULL;
+		pte = lookup_level(l2, asid, page, huge);
+		if(pte != NULL) {
+			*level = 2;
+			insert_level(l1, asid, page, pte, *huge);
+		}
+		return pte;
+	}
+
+	void insert(int asid, unsigned int page, PTE *pte, bool huge = false) {
+		/*
+			Function Name: insert
+			Arguments:
+				int asid: process id
+				unsigned int page: page number just walked, in memory now
+				PTE *pte: PTE of page
+				bool huge: whether page is part of a huge page, which gets the entry
+			Returns: void
+		*/
+		insert_level(l1, asid, page, pte, huge);
+		if(l2.size() > 0) insert_level(l2, asid, page, pte, huge);
+	}
+
+	bool invalidate_huge(int asid, unsigned int first_page) {
+		/*
+			Function Name: invalidate_huge
+			Arguments:
+				int asid: process id
+				unsigned int first_page: first page of huge page being demoted
+			Returns: bool - whether huge page had an entry, i.e. whether a shootdown was needed
+		*/
+		unsigned int huge_page = first_page >> huge_bits;
+		uint64_t tag = TLBLevel::key(asid, huge_page) | TLB_HUGE_TAG;
+		bool found = l1.invalidate(tag, huge_page);
+		if(l2.size() > 0 && l2.invalidate(tag, huge_page)) found = true;
+		return found;
+	}
+
+	bool invalidate(int asid, unsigned int page) {
+		/*
+			Function Name: invalidate
+			Arguments:
+				int asid: process id
+				unsigned int page: page number being unmapped
+			Returns: bool - whether page had an entry, i.e. whether a shootdown was needed
+		*/
+		uint64_t tag = TLBLevel::key(asid, page);
+		bool found = l1.invalidate(tag, page);
+		if(l2.size() > 0 && l2.invalidate(tag, page)) found = true;
+		return found;
+	}
+
+	void flush() {
+		l1.flush();
+		l2.flush();
+	}
+
+	void flush_asid(int asid) {
+		l1.flush_asid(asid);
+		l2.flush_asid(asid);
+	}
+
+	void state(Snapshot &snapshot, Process **processes) {
+		l1.state(snapshot, processes, huge_bits);
+		l2.state(snapshot, processes, huge_bits);
+	}
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+	Module Name: traceconv.cpp
+	Description: Converts an input file in text format into the binary trace format defined in 		binarytrace.h. Usage: ./traceconv <inputfile> <outputfile>
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "readinput.h"
+#include "binarytrace.h"
+
+
+void write_words(FILE *out, const uint32_t *words, size_t count) {
+	/*
+		Function Name: write_words
+		Arguments:
+			FILE *out: output file
+			const uint32_t *words: words to be written
+			size_t count: number of words
+		Returns: void
+		Description: writes words to output file and exits on failure
+	*/
+	if(fwrite(words, sizeof(uint32_t), count, out) != count) {
+		perror("fwrite");
+		exit(1);
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	/*
+		Function Name: main
+		Arguments:
+			int argc: number of command line arguments
+			char *argv[]: string array containing all the command line arguments
+		Returns: int: program exit status
+		Description: reads the text input file and writes it out as a binary trace
+	*/
+	if(argc != 3) {
+		fprintf(stderr, "usage: %s <inputfile> <outputfile>\n", argv[0]);
+		return 1;
+	}
+
+	//any address space that fits into a packed command
+	InputFile input(MAX_VPAGE_BITS);
+	input.openInputFile(argv[1]);
+	input.initProcess();
+	Process **processes = input.processes;
+	int num_processes = input.num_processes;
+
+	FILE *out = fopen(argv[2], "wb");
+	if(out == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+
+	//header is written once more at the end when command count is known
+	TraceHeader header;
+	header.magic = TRACE_MAGIC;
+	header.version = TRACE_VERSION;
+	header.num_processes = num_processes;
+	header.reserved = 0;
+	header.num_commands = 0;
+	header.commands_offset = sizeof(TraceHeader);
+	if(fwrite(&header, sizeof(header), 1, out) != 1) {
+		perror("fwrite");
+		return 1;
+	}
+
+	//process section
+	for(int i = 0; i < num_processes; i++) {
+		uint32_t num_vmas = processes[i]->vmas.size();
+		write_words(out, &num_vmas, 1);
+		header.commands_offset += sizeof(uint32_t);
+		for(uint32_t k = 0; k < num_vmas; k++) {
+			VMA &vma = processes[i]->vmas[k];
+			uint32_t words[5] = {(uint32_t)vma.start_page, (uint32_t)vma.end_page, (uint32_t)vma.write_protected, (uint32_t)vma.file_mapped, (uint32_t)vma.shared};
+			write_words(out, words, 5);
+			header.commands_offset += sizeof(words);
+		}
+	}
+
+	//command section, packed in blocks to keep writes large
+	Command command;
+	uint32_t block[4096];
+	size_t used = 0;
+	while(input.getNextCommand(&command)) {
+		if(command.num < 0 || command.num > TRACE_ARG_MASK) {
+			fprintf(stderr, "argument %d of command %llu does not fit into binary trace\n", command.num, (unsigned long long)header.num_commands);
+			return 1;
+		}
+		block[used++] = encode_command(command.cmd, command.num);
+		header.num_commands++;
+		if(used == 4096) {
+			write_words(out, block, used);
+			used = 0;
+		}
+	}
+	write_words(out, block, used);
+
+	rewind(out);
+	if(fwrite(&header, sizeof(header), 1, out) != 1) {
+		perror("fwrite");
+		return 1;
+	}
+	fclose(out);
+
+	printf("%d processes, %llu commands written to %s\n", num_processes, (unsigned long long)header.num_commands, argv[2]);
+	return 0;
+}
@@ -0,0 +1,297 @@
+/*
+	Module Name: tracegen.cpp
+	Description: Generates synthetic input files in the text format read by initProcess() and 		getNextCommand(). Every process gets VMAs covering part of its address space and a 		working set of pages in them, references are drawn from the working set with Zipf or 		loop locality. Processes may fork into other processes and exec the VMAs of another 		process. Output only depends on the options, the same seed gives the same trace on 		every platform.
+	Usage: ./tracegen [-p processes] [-n commands] [-s working_set] [-v vpage_bits] 		[-l zipf[:exponent]|loop|uniform] [-w write_ratio] [-c switch_rate] [-f fork_rate] 		[-r seed] [-o file]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "datastructures.h"
+
+#define TRACEGEN_MAX_VMAS 4 //VMAs per process, fewer if address space is small
+
+#define LOCALITY_ZIPF 0
+#define LOCALITY_LOOP 1
+#define LOCALITY_UNIFORM 2
+
+
+struct TraceProcess {
+	/*
+		Struct Name: TraceProcess
+		Description: defines a generated process, its VMAs, working set and reference state
+	*/
+	std::vector<VMA> vmas; //VMAs as written to the trace
+	std::vector<int> working_set; //pages referenced, hottest first
+	std::vector<bool> write_protected; //whether page at same index of working_set is write protected
+	int loop_pos; //next page of working set for loop locality
+};
+
+
+class TraceRandom {
+	/*
+		Class Name: TraceRandom
+		Description: random numbers of the generator. Only the raw output of mt19937_64 is 		used, as it is the same everywhere, unlike the distributions of the standard library.
+	*/
+private:
+	std::mt19937_64 engine;
+
+public:
+	TraceRandom(uint64_t seed) : engine(seed) {
+	}
+
+	double uniform() {
+		/*
+			Function Name: uniform
+			Returns: double - uniform number in [0, 1)
+		*/
+		return (engine() >> 11)*(1.0/9007199254740992.0);
+	}
+
+	int below(int n) {
+		/*
+			Function Name: below
+			Arguments:
+				int n: upper bound, exclusive
+			Returns: int - uniform number in [0, n)
+		*/
+		return (int)(uniform()*n);
+	}
+};
+
+
+void make_vmas(TraceProcess &process, int num_pages, int working_set, bool sharing, TraceRandom &random) {
+	/*
+		Function Name: make_vmas
+		Arguments:
+			TraceProcess &process: process whose VMAs and working set are generated
+			int num_pages: size of address space in pages
+			int working_set: number of pages in working set, at most the pages of all VMAs
+			bool sharing: whether VMAs may be shared, i.e. not copied on write after a fork
+			TraceRandom &random: random numbers of generator
+		Returns: void
+		Description: splits the address space into up to TRACEGEN_MAX_VMAS VMAs separated by 		holes. The VMAs together are large enough for the working set, which is a random 		choice of their pages.
+	*/
+	int vma_pages = std::max(working_set, num_pages*3/4);
+	if(vma_pages > num_pages) vma_pages = num_pages;
+	int num_vmas = std::min(TRACEGEN_MAX_VMAS, std::max(1, (num_pages - vma_pages) + 1));
+	int holes = num_pages - vma_pages;
+
+	//every VMA gets an equal share of the pages and the holes
+	int start = 0;
+	for(int k = 0; k < num_vmas; k++) {
+		int size = vma_pages/num_vmas + (k < vma_pages % num_vmas ? 1 : 0);
+		int hole = holes/num_vmas;
+		start += hole/2;
+		VMA vma;
+		vma.start_page = start;
+		vma.end_page = start + size - 1;
+		vma.write_protected = (random.below(4) == 0);
+		vma.file_mapped = (random.below(3) == 0);
+		vma.shared = sharing ? (random.below(4) == 0) : 0;
+		process.vmas.push_back(vma);
+		start += size + hole - hole/2;
+	}
+
+	//the working set is shuffled, so Zipf ranks do not follow page numbers
+	std::vector<int> pages;
+	std::vector<bool> protect;
+	for(int k = 0; k < (int)process.vmas.size(); k++) {
+		for(int j = process.vmas[k].start_page; j <= process.vmas[k].end_page; j++) {
+			pages.push_back(j);
+			protect.push_back(process.vmas[k].write_protected);
+		}
+	}
+	for(int i = (int)pages.size() - 1; i > 0; i--) {
+		int j = random.below(i + 1);
+		std::swap(pages[i], pages[j]);
+		bool t = protect[i];
+		protect[i] = protect[j];
+		protect[j] = t;
+	}
+	process.working_set.assign(pages.begin(), pages.begin() + working_set);
+	process.write_protected.assign(protect.begin(), protect.begin() + working_set);
+	process.loop_pos = 0;
+}
+
+
+int main(int argc, char *argv[]) {
+	/*
+		Function Name: main
+		Arguments:
+			int argc: number of command line arguments
+			char *argv[]: string array containing all the command line arguments
+		Returns: int: program exit status
+		Description: parses the options and writes the trace
+	*/
+	int num_processes = 4;
+	long int num_commands = 100000;
+	int working_set = 32;
+	int vpage_bits = 6;
+	int locality = LOCALITY_ZIPF;
+	double zipf_exponent = 1.0;
+	double write_ratio = 0.3;
+	double switch_rate = 0.01;
+	double fork_rate = 0;
+	uint64_t seed = 1;
+	char *output_file = NULL;
+
+	int opt;
+	while((opt = getopt(argc, argv, "p:n:s:v:l:w:c:f:r:o:")) != -1) {
+		switch(opt) {
+		case 'p':
+			num_processes = atoi(optarg);
+			break;
+		case 'n':
+			num_commands = atol(optarg);
+			break;
+		case 's':
+			working_set = atoi(optarg);
+			break;
+		case 'v':
+			vpage_bits = atoi(optarg);
+			break;
+		case 'l':
+			if(strncmp(optarg, "zipf", 4) == 0) {
+				locality = LOCALITY_ZIPF;
+				if(optarg[4] == ':') zipf_exponent = atof(optarg + 5);
+			} else if(strcmp(optarg, "loop") == 0) {
+				locality = LOCALITY_LOOP;
+			} else if(strcmp(optarg, "uniform") == 0) {
+				locality = LOCALITY_UNIFORM;
+			} else {
+				fprintf(stderr, "locality must be zipf[:exponent], loop or uniform\n");
+				return 1;
+			}
+			break;
+		case 'w':
+			write_ratio = atof(optarg);
+			break;
+		case 'c':
+			switch_rate = atof(optarg);
+			break;
+		case 'f':
+			fork_rate = atof(optarg);
+			break;
+		case 'r':
+			seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'o':
+			output_file = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-p processes] [-n commands] [-s working_set] [-v vpage_bits] [-l zipf[:exponent]|loop|uniform] [-w write_ratio] [-c switch_rate] [-f fork_rate] [-r seed] [-o file]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if(vpage_bits < 1 || vpage_bits > MAX_VPAGE_BITS) {
+		fprintf(stderr, "virtual address width must be between 1 and %d bits\n", MAX_VPAGE_BITS);
+		return 1;
+	}
+	int num_pages = 1 << vpage_bits;
+	if(num_processes < 1 || num_commands < 1 || working_set < 1 || working_set > num_pages) {
+		fprintf(stderr, "need at least one process and command, working set must be between 1 and %d pages\n", num_pages);
+		return 1;
+	}
+
+	FILE *out = stdout;
+	if(output_file != NULL) {
+		out = fopen(output_file, "w");
+		if(out == NULL) {
+			perror(output_file);
+			return 1;
+		}
+	}
+
+	TraceRandom random(seed);
+	std::vector<TraceProcess> processes(num_processes);
+	for(int i = 0; i < num_processes; i++) {
+		make_vmas(processes[i], num_pages, working_set, fork_rate > 0, random);
+	}
+
+	//exec loads the VMAs a process was generated with
+	std::vector<TraceProcess> programs = processes;
+
+	//cumulative Zipf probabilities of working set ranks, shared by all processes
+	std::vector<double> zipf_cdf(working_set);
+	double sum = 0;
+	for(int k = 0; k < working_set; k++) {
+		sum += 1.0/pow(k + 1, zipf_exponent);
+		zipf_cdf[k] = sum;
+	}
+	for(int k = 0; k < working_set; k++) {
+		zipf_cdf[k] /= sum;
+	}
+
+	//process section
+	fprintf(out, "# tracegen -p %d -n %ld -s %d -v %d -l %s", num_processes, num_commands, working_set, vpage_bits, locality == LOCALITY_LOOP ? "loop" : (locality == LOCALITY_UNIFORM ? "uniform" : "zipf"));
+	if(locality == LOCALITY_ZIPF) fprintf(out, ":%g", zipf_exponent);
+	fprintf(out, " -w %g -c %g", write_ratio, switch_rate);
+	if(fork_rate > 0) fprintf(out, " -f %g", fork_rate);
+	fprintf(out, " -r %llu\n#\n%d\n", (unsigned long long)seed, num_processes);
+	for(int i = 0; i < num_processes; i++) {
+		fprintf(out, "#### process %d\n%d\n", i, (int)processes[i].vmas.size());
+		for(int k = 0; k < (int)processes[i].vmas.size(); k++) {
+			VMA &vma = processes[i].vmas[k];
+			if(fork_rate > 0)
+				fprintf(out, "%d %d %d %d %d\n", vma.start_page, vma.end_page, vma.write_protected, vma.file_mapped, vma.shared);
+			else
+				fprintf(out, "%d %d %d %d\n", vma.start_page, vma.end_page, vma.write_protected, vma.file_mapped);
+		}
+	}
+
+	//command section, always starts with a context switch
+	int curr_proc = random.below(num_processes);
+	fprintf(out, "c %d\n", curr_proc);
+	for(long int n = 1; n < num_commands; n++) {
+		if(num_processes > 1 && random.uniform() < switch_rate) {
+			curr_proc = random.below(num_processes);
+			fprintf(out, "c %d\n", curr_proc);
+			continue;
+		}
+
+		//a fork copies the current process into another one, an exec, half as frequent,
+		//starts the current process over with the VMAs of a random one
+		if(num_processes > 1 && fork_rate > 0) {
+			double u = random.uniform();
+			if(u < fork_rate) {
+				int child = random.below(num_processes - 1);
+				if(child >= curr_proc) child++;
+				processes[child] = processes[curr_proc];
+				fprintf(out, "f %d\n", child);
+				continue;
+			}
+			if(u < fork_rate*1.5) {
+				int program = random.below(num_processes);
+				processes[curr_proc] = programs[program];
+				fprintf(out, "e %d\n", program);
+				continue;
+			}
+		}
+
+		TraceProcess &process = processes[curr_proc];
+		int rank;
+		if(locality == LOCALITY_LOOP) {
+			rank = process.loop_pos;
+			process.loop_pos = (process.loop_pos + 1) % working_set;
+		} else if(locality == LOCALITY_UNIFORM) {
+			rank = random.below(working_set);
+		} else {
+			rank = std::lower_bound(zipf_cdf.begin(), zipf_cdf.end(), random.uniform()) - zipf_cdf.begin();
+			if(rank >= working_set) rank = working_set - 1;
+		}
+
+		//writes to write protected pages are left in, they are part of what is simulated
+		char cmd = (random.uniform() < write_ratio) ? 'w' : 'r';
+		fprintf(out, "%c %d\n", cmd, process.working_set[rank]);
+	}
+
+	if(out != stdout) fclose(out);
+	return 0;
+}